@@ -0,0 +1,559 @@
+#include "core/TradingEngine.h"
+#include "core/MonteCarlo.h"
+#include "core/CandleRangeIndex.h"
+#include "core/CandleLod.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Counts heap allocations made while a benchmark's timed region is running.
+namespace
+{
+    std::atomic<bool> g_count_allocs{false};
+    std::atomic<uint64_t> g_alloc_count{0};
+    volatile uint64_t g_sink = 0;
+}
+
+void* operator new(size_t size)
+{
+    if (g_count_allocs.load(std::memory_order_relaxed)) g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+class EngineBench
+{
+public:
+    static void GenerateMarketData(TradingEngine& e) { e.GenerateMarketData(); }
+    static void CheckLimitOrders(TradingEngine& e) { e.CheckLimitOrders(0.0); }
+    static void UpdateAccount(TradingEngine& e) { e.UpdateAccount(); }
+    static void AppendCandle(TradingEngine& e, const Candle& c) { e.AppendCandle(c); }
+    static void ExecuteFill(TradingEngine& e, bool is_buy, Notional notional, Qty amount, bool reduce_only)
+    {
+        e.ExecuteFill(is_buy, notional, amount, reduce_only, ORDER_MARKET, MonotonicNanos(), 0.0);
+    }
+};
+
+namespace
+{
+    struct BenchResult
+    {
+        std::string name;
+        uint64_t iterations = 0;
+        double ns_per_op = 0.0;
+        double ops_per_sec = 0.0;
+        double allocs_per_op = 0.0;
+        double p50_ns = 0.0;
+        double p90_ns = 0.0;
+        double p99_ns = 0.0;
+    };
+
+    struct BenchOptions
+    {
+        std::string filter;
+        std::string json_path;
+        std::string baseline_path;
+        double threshold_pct = 10.0;
+        size_t max_candles = 10000000;
+    };
+
+    std::vector<BenchResult> g_results;
+    BenchOptions g_opts;
+
+    bool Selected(const std::string& name)
+    {
+        return g_opts.filter.empty() || name.find(g_opts.filter) != std::string::npos;
+    }
+
+    double Percentile(std::vector<double>& samples, double pct)
+    {
+        if (samples.empty()) return 0.0;
+        size_t idx = (size_t)(pct / 100.0 * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return samples[idx];
+    }
+
+    // Runs `op` in batches of `batch` calls. `prepare` runs untimed (and
+    // uncounted) before every batch; each batch contributes one ns/op sample.
+    template <typename Prepare, typename Op>
+    void Measure(const std::string& name, uint64_t iterations, uint64_t batch, Prepare prepare, Op op)
+    {
+        if (!Selected(name)) return;
+
+        using clock = std::chrono::steady_clock;
+        uint64_t batches = std::max<uint64_t>(1, iterations / batch);
+        uint64_t warmup = std::max<uint64_t>(1, batches / 20);
+
+        for (uint64_t b = 0; b < warmup; ++b)
+        {
+            prepare();
+            for (uint64_t i = 0; i < batch; ++i) op();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(batches);
+        double total_ns = 0.0;
+        uint64_t allocs = 0;
+
+        for (uint64_t b = 0; b < batches; ++b)
+        {
+            prepare();
+
+            g_alloc_count.store(0, std::memory_order_relaxed);
+            g_count_allocs.store(true, std::memory_order_relaxed);
+            auto start = clock::now();
+            for (uint64_t i = 0; i < batch; ++i) op();
+            auto end = clock::now();
+            g_count_allocs.store(false, std::memory_order_relaxed);
+            allocs += g_alloc_count.load(std::memory_order_relaxed);
+
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            total_ns += ns;
+            samples.push_back(ns / batch);
+        }
+
+        BenchResult r;
+        r.name = name;
+        r.iterations = batches * batch;
+        r.ns_per_op = total_ns / r.iterations;
+        r.ops_per_sec = (r.ns_per_op > 0.0) ? 1e9 / r.ns_per_op : 0.0;
+        r.allocs_per_op = (double)allocs / r.iterations;
+        r.p50_ns = Percentile(samples, 50.0);
+        r.p90_ns = Percentile(samples, 90.0);
+        r.p99_ns = Percentile(samples, 99.0);
+
+        std::printf("%-34s %10llu %12.1f %14.0f %10.3f %10.1f %10.1f %10.1f\n", r.name.c_str(), (unsigned long long)r.iterations,
+            r.ns_per_op, r.ops_per_sec, r.allocs_per_op, r.p50_ns, r.p90_ns, r.p99_ns);
+        std::fflush(stdout);
+        g_results.push_back(r);
+    }
+
+    void NoPrepare() {}
+
+    void InitEngine(TradingEngine& engine)
+    {
+        engine.Init(1234);
+    }
+
+    void BenchGenerateMarketData()
+    {
+        TradingEngine engine;
+        InitEngine(engine);
+        Measure("GenerateMarketData", 200000, 100, NoPrepare, [&] { EngineBench::GenerateMarketData(engine); });
+    }
+
+    // One op is a full batch of PATH_LANES one-day paths.
+    void BenchPathGenerator()
+    {
+        Instrument inst;
+        PathGenerator generator(MarketModel(), inst, 1234);
+        std::vector<Candle> out;
+        uint64_t path = 0;
+        std::string name = "GeneratePaths/" + std::to_string(PATH_LANES) + "x1440";
+        Measure(name, 2000, 1, NoPrepare, [&]
+        {
+            generator.Generate(path, PATH_LANES, 1440, inst.ToTicks(42000.0), 0.0, out);
+            path += PATH_LANES;
+        });
+    }
+
+    void BenchCheckLimitOrders()
+    {
+        const int counts[] = {10, 100, 1000, 10000, 100000};
+        for (int resting : counts)
+        {
+            std::string name = "CheckLimitOrders/" + std::to_string(resting);
+            if (!Selected(name)) continue;
+
+            TradingEngine engine;
+            InitEngine(engine);
+            const Instrument& inst = engine.state.instrument;
+            std::mt19937 rng(99);
+            std::uniform_real_distribution<double> offset(0.0, 2000.0);
+
+            // Keep `resting` orders on both sides of the market and move it one
+            // tick before each measured check, so every check has real fills.
+            auto prepare = [&]
+            {
+                while ((int)engine.state.open_orders.size() < resting)
+                {
+                    bool is_buy = rng() & 1;
+                    Price p = engine.state.current_price + (is_buy ? -1 : 1) * inst.ToTicks(offset(rng));
+                    engine.PlaceOrder(is_buy, ORDER_LIMIT, p, inst.ToLots(0.1));
+                }
+                EngineBench::GenerateMarketData(engine);
+            };
+
+            uint64_t iterations = std::max<uint64_t>(20, 2000000 / (uint64_t)resting);
+            Measure(name, std::min<uint64_t>(iterations, 2000), 1, prepare, [&] { EngineBench::CheckLimitOrders(engine); });
+        }
+    }
+
+    // Full tick with resting orders parked far from the market: the cost should not grow with the count.
+    void BenchStep()
+    {
+        const int counts[] = {10, 1000, 50000};
+        for (int resting : counts)
+        {
+            std::string name = "Step/" + std::to_string(resting);
+            if (!Selected(name)) continue;
+
+            TradingEngine engine;
+            InitEngine(engine);
+            const Instrument& inst = engine.state.instrument;
+            std::mt19937 rng(21);
+            std::uniform_real_distribution<double> offset(5000.0, 10000.0);
+
+            auto refill = [&]
+            {
+                while ((int)engine.state.open_orders.size() < resting)
+                {
+                    bool is_buy = rng() & 1;
+                    Price p = engine.state.current_price + (is_buy ? -1 : 1) * inst.ToTicks(offset(rng));
+                    engine.PlaceOrder(is_buy, ORDER_LIMIT, p, inst.ToLots(0.1));
+                }
+            };
+
+            Measure(name, 50000, 10, refill, [&] { engine.Step(); });
+        }
+
+        // Tick mode: one op is a whole minute of 1000 trades, 1000 resting orders.
+        const std::string name = "StepTicks/1000";
+        if (!Selected(name)) return;
+
+        TradingEngine engine;
+        InitEngine(engine);
+        engine.SetTicksPerCandle(1000);
+        const Instrument& inst = engine.state.instrument;
+        std::mt19937 rng(22);
+        std::uniform_real_distribution<double> offset(5000.0, 10000.0);
+        auto refill = [&]
+        {
+            while ((int)engine.state.open_orders.size() < 1000)
+            {
+                bool is_buy = rng() & 1;
+                Price p = engine.state.current_price + (is_buy ? -1 : 1) * inst.ToTicks(offset(rng));
+                engine.PlaceOrder(is_buy, ORDER_LIMIT, p, inst.ToLots(0.1));
+            }
+        };
+        Measure(name, 5000, 10, refill, [&] { engine.Step(); });
+    }
+
+    void BenchPlaceOrder()
+    {
+        {
+            TradingEngine engine;
+            InitEngine(engine);
+            const Instrument& inst = engine.state.instrument;
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<double> offset(50.0, 500.0);
+            bool is_buy = true;
+
+            Measure("PlaceOrder/Limit", 50000, 100, NoPrepare, [&]
+            {
+                Price p = engine.state.current_price + (is_buy ? -1 : 1) * inst.ToTicks(offset(rng));
+                engine.PlaceOrder(is_buy, ORDER_LIMIT, p, inst.ToLots(0.1));
+                is_buy = !is_buy;
+            });
+        }
+
+        const int taker_types[] = {ORDER_MARKET, ORDER_FOK};
+        for (int type : taker_types)
+        {
+            TradingEngine engine;
+            InitEngine(engine);
+            const Instrument& inst = engine.state.instrument;
+            bool is_buy = true;
+
+            auto prepare = [&] { EngineBench::GenerateMarketData(engine); };
+            std::string name = (type == ORDER_MARKET) ? "PlaceOrder/Market" : "PlaceOrder/FOK";
+
+            Measure(name, 100000, 16, prepare, [&]
+            {
+                Price limit = engine.state.current_price + (is_buy ? 1 : -1) * inst.ToTicks(1000.0);
+                engine.PlaceOrder(is_buy, type, limit, inst.ToLots(0.01));
+                is_buy = !is_buy;
+            });
+        }
+    }
+
+    void BenchCancelOrder()
+    {
+        const int counts[] = {1000, 100000};
+        for (int resting : counts)
+        {
+            std::string suffix = "/" + std::to_string(resting);
+            if (!Selected("CancelOrder" + suffix) && !Selected("CancelAllOrders" + suffix)) continue;
+
+            TradingEngine engine;
+            InitEngine(engine);
+            const Instrument& inst = engine.state.instrument;
+            std::mt19937 rng(11);
+            std::uniform_real_distribution<double> offset(1000.0, 3000.0);
+
+            // Far enough from the market that nothing fills while the book is refilled.
+            auto refill = [&]
+            {
+                while ((int)engine.state.open_orders.size() < resting)
+                {
+                    bool is_buy = rng() & 1;
+                    Price p = engine.state.current_price + (is_buy ? -1 : 1) * inst.ToTicks(offset(rng));
+                    engine.PlaceOrder(is_buy, ORDER_LIMIT, p, inst.ToLots(0.1));
+                }
+            };
+
+            Measure("CancelOrder" + suffix, 100000, 1, refill, [&]
+            {
+                engine.CancelOrder(engine.state.open_orders[rng() % engine.state.open_orders.size()].id);
+            });
+            Measure("CancelAllOrders" + suffix, 20, 1, refill, [&] { engine.CancelAllOrders(); });
+        }
+    }
+
+    void BenchExecuteFill()
+    {
+        TradingEngine engine;
+        InitEngine(engine);
+        const Instrument& inst = engine.state.instrument;
+        Qty lots = inst.ToLots(0.5);
+        bool opening = true;
+
+        Measure("ExecuteFill", 500000, 100, NoPrepare, [&]
+        {
+            EngineBench::ExecuteFill(engine, opening, engine.state.current_price * lots, lots, !opening);
+            opening = !opening;
+        });
+    }
+
+    void BenchUpdateAccount()
+    {
+        TradingEngine engine;
+        InitEngine(engine);
+        engine.PlaceOrder(true, ORDER_MARKET, 0, engine.state.instrument.ToLots(1.0));
+        Measure("UpdateAccount", 1000000, 1000, NoPrepare, [&] { EngineBench::UpdateAccount(engine); });
+    }
+
+    // One equity sample plus a full summary, as Step does for every candle.
+    void BenchPerformanceStats()
+    {
+        TradingState state;
+        PerformanceTracker tracker;
+        std::mt19937 rng(11);
+        std::normal_distribution<double> step(0.0, 0.001);
+        double equity = 50000.0;
+        Measure("PerformanceStats", 1000000, 1000, NoPrepare, [&]
+        {
+            equity *= 1.0 + step(rng);
+            tracker.AddEquity(equity);
+            tracker.Summarize(state, state.performance);
+        });
+    }
+
+    void BenchCandles()
+    {
+        const size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+        const char* tf_names[TIMEFRAME_COUNT] = {"1m", "5m", "15m", "1h", "4h", "D"};
+
+        for (size_t n : sizes)
+        {
+            if (n > g_opts.max_candles) continue;
+
+            std::string suffix = "/" + std::to_string(n);
+            bool any = Selected("AppendCandle" + suffix) || Selected("ChartAutoFit" + suffix) || Selected("ChartLod" + suffix);
+            for (const char* tf : tf_names) any = any || Selected(std::string("GetCandles/") + tf + suffix);
+            if (!any) continue;
+
+            TradingEngine engine;
+            engine.state.candles.SetCapacity(n);
+            for (auto& series : engine.state.aggregated_candles) series.SetCapacity(n);
+
+            std::mt19937 rng(5);
+            std::normal_distribution<double> walk(0.0, 3000.0);
+            Price price = engine.state.current_price;
+            double t = 0.0;
+            auto next_candle = [&]
+            {
+                Price close = price + (Price)walk(rng);
+                Candle c = {t, price, std::max(price, close) + 500, std::min(price, close) - 500, close, 10000};
+                price = close;
+                t += 60.0;
+                return c;
+            };
+            for (size_t i = 0; i < n; ++i) EngineBench::AppendCandle(engine, next_candle());
+
+            for (int tf = 0; tf < TIMEFRAME_COUNT; ++tf)
+            {
+                Measure(std::string("GetCandles/") + tf_names[tf] + suffix, 1000000, 1000, NoPrepare, [&]
+                {
+                    const CandleSeries& series = TradingEngine::GetCandles(engine.state, tf);
+                    g_sink += series.Size();
+                });
+            }
+
+            // Y range of a one-week window (or the whole series) at a random position.
+            const CandleSeries& minutes = engine.state.candles;
+            CandleRangeIndex y_range;
+            y_range.Sync(minutes);
+            double first = minutes.Front().time;
+            double window = std::min(7 * 86400.0, minutes.Back().time - first);
+            std::uniform_real_distribution<double> window_start(first, minutes.Back().time - window);
+            Measure("ChartAutoFit" + suffix, 200000, 100, NoPrepare, [&]
+            {
+                double t0 = window_start(rng);
+                Price low = 0, high = 0;
+                y_range.Sync(minutes);
+                y_range.Query(minutes, t0, t0 + window, low, high);
+                g_sink += (uint64_t)(high - low);
+            });
+
+            // Whole series zoomed out onto a 2000 pixel wide plot.
+            CandleLod lod;
+            CandleColumns envelopes;
+            lod.Sync(minutes);
+            double span = minutes.Back().time - first;
+            Measure("ChartLod" + suffix, 20000, 10, NoPrepare, [&]
+            {
+                lod.Sync(minutes);
+                if (!lod.Decimate(minutes, first, first + span, span / 2000.0, envelopes)) envelopes.Clear();
+                g_sink += envelopes.Size();
+            });
+
+            Measure("AppendCandle" + suffix, 200000, 100, NoPrepare, [&] { EngineBench::AppendCandle(engine, next_candle()); });
+        }
+    }
+
+    bool WriteJson(const std::string& path)
+    {
+        FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) return false;
+
+        std::fprintf(f, "[\n");
+        for (size_t i = 0; i < g_results.size(); ++i)
+        {
+            const BenchResult& r = g_results[i];
+            std::fprintf(f, "{\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"allocs_per_op\": %.4f, \"p50_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f}%s\n",
+                r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.ops_per_sec, r.allocs_per_op, r.p50_ns, r.p90_ns, r.p99_ns,
+                (i + 1 < g_results.size()) ? "," : "");
+        }
+        std::fprintf(f, "]\n");
+        std::fclose(f);
+        return true;
+    }
+
+    // Reads a file written by WriteJson (one result object per line).
+    bool ReadJson(const std::string& path, std::vector<BenchResult>& out)
+    {
+        FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) return false;
+
+        char line[1024];
+        while (std::fgets(line, sizeof(line), f))
+        {
+            char name[256];
+            BenchResult r;
+            unsigned long long iterations = 0;
+            if (std::sscanf(line, " {\"name\": \"%255[^\"]\", \"iterations\": %llu, \"ns_per_op\": %lf, \"ops_per_sec\": %lf, \"allocs_per_op\": %lf",
+                    name, &iterations, &r.ns_per_op, &r.ops_per_sec, &r.allocs_per_op) == 5)
+            {
+                r.name = name;
+                r.iterations = iterations;
+                out.push_back(r);
+            }
+        }
+        std::fclose(f);
+        return true;
+    }
+
+    int CompareWithBaseline(const std::string& path)
+    {
+        std::vector<BenchResult> baseline;
+        if (!ReadJson(path, baseline))
+        {
+            std::fprintf(stderr, "cannot read baseline %s\n", path.c_str());
+            return 1;
+        }
+
+        int regressions = 0;
+        std::printf("\n%-34s %12s %12s %9s\n", "benchmark", "baseline", "current", "change");
+        for (const BenchResult& cur : g_results)
+        {
+            auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BenchResult& b) { return b.name == cur.name; });
+            if (it == baseline.end() || it->ns_per_op <= 0.0) continue;
+
+            double change = (cur.ns_per_op - it->ns_per_op) / it->ns_per_op * 100.0;
+            bool regressed = change > g_opts.threshold_pct;
+            if (regressed) regressions++;
+            std::printf("%-34s %12.1f %12.1f %+8.1f%%%s\n", cur.name.c_str(), it->ns_per_op, cur.ns_per_op, change, regressed ? "  REGRESSION" : "");
+        }
+
+        std::printf("\n%d regression(s) above %.1f%%\n", regressions, g_opts.threshold_pct);
+        return regressions > 0 ? 2 : 0;
+    }
+
+    void PrintUsage(const char* exe)
+    {
+        std::printf("Usage: %s [options]\n", exe);
+        std::printf("  --filter TEXT       only run benchmarks whose name contains TEXT\n");
+        std::printf("  --json PATH         write results as JSON\n");
+        std::printf("  --baseline PATH     compare against a previous --json file, exit 2 on regression\n");
+        std::printf("  --threshold PCT     ns/op increase counted as a regression (default 10)\n");
+        std::printf("  --max-candles N     largest candle history to benchmark (default 10000000)\n");
+    }
+
+    bool ParseArgs(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            bool has_value = (i + 1 < argc);
+
+            if (!std::strcmp(arg, "--filter") && has_value) g_opts.filter = argv[++i];
+            else if (!std::strcmp(arg, "--json") && has_value) g_opts.json_path = argv[++i];
+            else if (!std::strcmp(arg, "--baseline") && has_value) g_opts.baseline_path = argv[++i];
+            else if (!std::strcmp(arg, "--threshold") && has_value) g_opts.threshold_pct = std::atof(argv[++i]);
+            else if (!std::strcmp(arg, "--max-candles") && has_value) g_opts.max_candles = (size_t)std::atoll(argv[++i]);
+            else return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (!ParseArgs(argc, argv))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::printf("%-34s %10s %12s %14s %10s %10s %10s %10s\n", "benchmark", "iters", "ns/op", "ops/sec", "allocs/op", "p50", "p90", "p99");
+
+    BenchGenerateMarketData();
+    BenchPathGenerator();
+    BenchCheckLimitOrders();
+    BenchStep();
+    BenchPlaceOrder();
+    BenchCancelOrder();
+    BenchExecuteFill();
+    BenchUpdateAccount();
+    BenchPerformanceStats();
+    BenchCandles();
+
+    if (!g_opts.json_path.empty() && !WriteJson(g_opts.json_path))
+    {
+        std::fprintf(stderr, "cannot write %s\n", g_opts.json_path.c_str());
+        return 1;
+    }
+    if (!g_opts.baseline_path.empty()) return CompareWithBaseline(g_opts.baseline_path);
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "CandleLod.h"
+#include <algorithm>
+#include <cmath>
+
+void CandleColumns::Clear()
+{
+    times.clear();
+    opens.clear();
+    highs.clear();
+    lows.clear();
+    closes.clear();
+}
+
+void CandleColumns::PushBack(double time, Price open, Price high, Price low, Price close)
+{
+    times.push_back(time);
+    opens.push_back(open);
+    highs.push_back(high);
+    lows.push_back(low);
+    closes.push_back(close);
+}
+
+void CandleLod::Reset(const CandleSeries& series)
+{
+    generation = series.Generation();
+    capacity = series.Capacity();
+    synced = series.TotalPushed() - series.Size();
+
+    levels.clear();
+    for (int shift = 2; ((size_t)1 << shift) <= capacity; shift += 2)
+    {
+        // A window of `capacity` candles touches at most (capacity >> shift) + 2 groups.
+        levels.push_back({shift, std::vector<Envelope>((capacity >> shift) + 2)});
+    }
+}
+
+void CandleLod::Sync(const CandleSeries& series)
+{
+    if (series.Generation() != generation || series.Capacity() != capacity || series.TotalPushed() < synced) Reset(series);
+
+    uint64_t pushed = series.TotalPushed();
+    if (pushed == 0) return;
+
+    // The newest candle may have changed in place since the last Sync.
+    uint64_t oldest = pushed - series.Size();
+    uint64_t from = (synced > 0) ? synced - 1 : 0;
+    if (from < oldest) from = oldest;
+
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        int shift = levels[level].shift;
+        for (uint64_t group = from >> shift; group <= (pushed - 1) >> shift; ++group)
+        {
+            RebuildGroup(series, level, group);
+        }
+    }
+    synced = pushed;
+}
+
+void CandleLod::RebuildGroup(const CandleSeries& series, size_t level, uint64_t group)
+{
+    uint64_t pushed = series.TotalPushed();
+    uint64_t oldest = pushed - series.Size();
+
+    Envelope e = {};
+    bool empty = true;
+    auto merge = [&](double time, Price open, Price high, Price low, Price close)
+    {
+        if (empty)
+        {
+            e = {time, open, high, low, close};
+            empty = false;
+            return;
+        }
+        e.high = std::max(e.high, high);
+        e.low = std::min(e.low, low);
+        e.close = close;
+    };
+
+    if (level == 0)
+    {
+        uint64_t first = std::max(group << levels[0].shift, oldest);
+        uint64_t end = std::min((group + 1) << levels[0].shift, pushed);
+        for (uint64_t seq = first; seq < end; ++seq)
+        {
+            size_t slot = series.Slot((size_t)(seq - oldest));
+            merge(series.Times()[slot], series.Opens()[slot], series.Highs()[slot], series.Lows()[slot], series.Closes()[slot]);
+        }
+    } else
+    {
+        // Built from the four groups of the level below that are still (partly) in the series.
+        const Level& below = levels[level - 1];
+        for (uint64_t child = group * 4; child < group * 4 + 4; ++child)
+        {
+            if ((child << below.shift) >= pushed || ((child + 1) << below.shift) <= oldest) continue;
+            const Envelope& c = below.slots[child % below.slots.size()];
+            merge(c.time, c.open, c.high, c.low, c.close);
+        }
+    }
+
+    Level& target = levels[level];
+    target.slots[group % target.slots.size()] = e;
+}
+
+bool CandleLod::Decimate(const CandleSeries& series, double t_min, double t_max, double seconds_per_column, CandleColumns& out) const
+{
+    size_t size = series.Size();
+    if (size == 0 || seconds_per_column <= 0.0 || t_min > t_max) return false;
+
+    const double* times = series.Times();
+    size_t lo = 0, hi = size;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (times[series.Slot(mid)] < t_min) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t first = lo;
+
+    hi = size;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (times[series.Slot(mid)] <= t_max) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t count = lo - first;
+
+    double columns = (t_max - t_min) / seconds_per_column;
+    if ((double)count <= columns) return false;
+
+    // Coarsest level with at least one envelope per column; -1 merges raw candles.
+    double per_column = count / std::max(columns, 1.0);
+    int level = -1;
+    while (level + 1 < (int)levels.size() && (double)((uint64_t)1 << levels[level + 1].shift) <= per_column) ++level;
+
+    out.Clear();
+    int64_t last_column = (int64_t)std::ceil(columns);
+    int64_t open_column = -1;
+    auto add = [&](double time, Price open, Price high, Price low, Price close)
+    {
+        int64_t column = (int64_t)std::floor((time - t_min) / seconds_per_column);
+        column = std::min(std::max(column, (int64_t)0), last_column);
+        if (column == open_column)
+        {
+            size_t back = out.Size() - 1;
+            out.highs[back] = std::max(out.highs[back], high);
+            out.lows[back] = std::min(out.lows[back], low);
+            out.closes[back] = close;
+            return;
+        }
+        out.PushBack(t_min + (column + 0.5) * seconds_per_column, open, high, low, close);
+        open_column = column;
+    };
+
+    if (level < 0)
+    {
+        for (size_t i = first; i < first + count; ++i)
+        {
+            size_t slot = series.Slot(i);
+            add(times[slot], series.Opens()[slot], series.Highs()[slot], series.Lows()[slot], series.Closes()[slot]);
+        }
+        return true;
+    }
+
+    const Level& l = levels[level];
+    uint64_t oldest = series.TotalPushed() - size;
+    uint64_t first_group = (oldest + first) >> l.shift;
+    uint64_t last_group = (oldest + first + count - 1) >> l.shift;
+    for (uint64_t group = first_group; group <= last_group; ++group)
+    {
+        const Envelope& e = l.slots[group % l.slots.size()];
+        add(e.time, e.open, e.high, e.low, e.close);
+    }
+    return true;
+}
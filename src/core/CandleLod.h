@@ -0,0 +1,61 @@
+#pragma once
+#include "Models.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Candles as plain columns, the shape DrawCandlesticks consumes.
+struct CandleColumns
+{
+    std::vector<double> times;
+    std::vector<Price> opens;
+    std::vector<Price> highs;
+    std::vector<Price> lows;
+    std::vector<Price> closes;
+
+    size_t Size() const { return times.size(); }
+    void Clear();
+    void PushBack(double time, Price open, Price high, Price low, Price close);
+};
+
+// Level-of-detail pyramid over a CandleSeries for drawing zoomed-out charts.
+// Level k merges groups of 4^k consecutive candles into one OHLC envelope;
+// Decimate picks the coarsest level that still has at least one envelope
+// per pixel column, so its cost follows the plot width, not the number of
+// candles in view. Levels are rings that follow the series' eviction and
+// are kept up to date incrementally by Sync, like CandleRangeIndex.
+class CandleLod
+{
+public:
+    void Sync(const CandleSeries& series);
+
+    // Merges the candles with t_min <= time <= t_max into one envelope per
+    // column of seconds_per_column, centred on the column. Returns false, with
+    // out untouched, when the range holds no more candles than columns and
+    // drawing them directly is just as cheap.
+    bool Decimate(const CandleSeries& series, double t_min, double t_max, double seconds_per_column, CandleColumns& out) const;
+
+private:
+    struct Envelope
+    {
+        double time;
+        Price open;
+        Price high;
+        Price low;
+        Price close;
+    };
+
+    struct Level
+    {
+        int shift;                     // group size is 1 << shift candles
+        std::vector<Envelope> slots;   // group g lives in slot g % slots.size()
+    };
+
+    uint64_t generation = 0;
+    size_t capacity = 0;
+    uint64_t synced = 0;
+    std::vector<Level> levels;
+
+    void Reset(const CandleSeries& series);
+    void RebuildGroup(const CandleSeries& series, size_t level, uint64_t group);
+};
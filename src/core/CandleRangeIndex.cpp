@@ -0,0 +1,161 @@
+#include "CandleRangeIndex.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr Price NO_LOW = std::numeric_limits<Price>::max();
+    constexpr Price NO_HIGH = std::numeric_limits<Price>::lowest();
+}
+
+void CandleRangeIndex::Reset(const CandleSeries& series)
+{
+    generation = series.Generation();
+    capacity = series.Capacity();
+    synced = series.TotalPushed() - series.Size();
+
+    // A window of `capacity` candles touches at most capacity / BLOCK_SIZE + 2 blocks.
+    block_slots = capacity / BLOCK_SIZE + 2;
+    leaf_count = 1;
+    while (leaf_count < block_slots) leaf_count <<= 1;
+    tree.assign(2 * leaf_count, {NO_LOW, NO_HIGH});
+}
+
+void CandleRangeIndex::Sync(const CandleSeries& series)
+{
+    if (series.Generation() != generation || series.Capacity() != capacity || series.TotalPushed() < synced) Reset(series);
+
+    uint64_t pushed = series.TotalPushed();
+    if (pushed == 0) return;
+
+    // The newest candle may have changed in place since the last Sync.
+    uint64_t oldest = pushed - series.Size();
+    uint64_t from = (synced > 0) ? synced - 1 : 0;
+    if (from < oldest) from = oldest;
+
+    for (uint64_t block = from / BLOCK_SIZE; block <= (pushed - 1) / BLOCK_SIZE; ++block)
+    {
+        RebuildBlock(series, block);
+    }
+    synced = pushed;
+}
+
+void CandleRangeIndex::RebuildBlock(const CandleSeries& series, uint64_t block)
+{
+    uint64_t pushed = series.TotalPushed();
+    uint64_t oldest = pushed - series.Size();
+    uint64_t first = std::max(block * BLOCK_SIZE, oldest);
+    uint64_t end = std::min((block + 1) * BLOCK_SIZE, pushed);
+
+    const Price* lows = series.Lows();
+    const Price* highs = series.Highs();
+    Range r = {NO_LOW, NO_HIGH};
+    for (uint64_t seq = first; seq < end; ++seq)
+    {
+        size_t slot = series.Slot((size_t)(seq - oldest));
+        r.low = std::min(r.low, lows[slot]);
+        r.high = std::max(r.high, highs[slot]);
+    }
+
+    size_t node = leaf_count + (size_t)(block % block_slots);
+    tree[node] = r;
+    for (node >>= 1; node > 0; node >>= 1)
+    {
+        const Range& left = tree[2 * node];
+        const Range& right = tree[2 * node + 1];
+        tree[node] = {std::min(left.low, right.low), std::max(left.high, right.high)};
+    }
+}
+
+CandleRangeIndex::Range CandleRangeIndex::QuerySlots(size_t first, size_t last) const
+{
+    Range r = {NO_LOW, NO_HIGH};
+    for (size_t lo = first + leaf_count, hi = last + leaf_count + 1; lo < hi; lo >>= 1, hi >>= 1)
+    {
+        if (lo & 1)
+        {
+            r.low = std::min(r.low, tree[lo].low);
+            r.high = std::max(r.high, tree[lo].high);
+            ++lo;
+        }
+        if (hi & 1)
+        {
+            --hi;
+            r.low = std::min(r.low, tree[hi].low);
+            r.high = std::max(r.high, tree[hi].high);
+        }
+    }
+    return r;
+}
+
+CandleRangeIndex::Range CandleRangeIndex::QueryBlocks(uint64_t first_block, uint64_t last_block) const
+{
+    size_t first = (size_t)(first_block % block_slots);
+    size_t last = (size_t)(last_block % block_slots);
+    if (first <= last) return QuerySlots(first, last);
+
+    Range a = QuerySlots(first, block_slots - 1);
+    Range b = QuerySlots(0, last);
+    return {std::min(a.low, b.low), std::max(a.high, b.high)};
+}
+
+bool CandleRangeIndex::Query(const CandleSeries& series, double t_min, double t_max, Price& low, Price& high) const
+{
+    size_t size = series.Size();
+    if (size == 0 || tree.empty() || t_min > t_max) return false;
+
+    const double* times = series.Times();
+    const Price* lows = series.Lows();
+    const Price* highs = series.Highs();
+
+    // Candle times ascend, so the window maps to one index range.
+    size_t lo = 0, hi = size;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (times[series.Slot(mid)] < t_min) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t first = lo;
+
+    hi = size;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (times[series.Slot(mid)] <= t_max) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == first) return false;
+    size_t last = lo - 1;
+
+    uint64_t oldest = series.TotalPushed() - size;
+    uint64_t first_block = (oldest + first) / BLOCK_SIZE;
+    uint64_t last_block = (oldest + last) / BLOCK_SIZE;
+
+    Range r = {NO_LOW, NO_HIGH};
+    auto scan = [&](size_t from, size_t to)
+    {
+        for (size_t i = from; i <= to; ++i)
+        {
+            size_t slot = series.Slot(i);
+            r.low = std::min(r.low, lows[slot]);
+            r.high = std::max(r.high, highs[slot]);
+        }
+    };
+
+    if (last_block - first_block < 2)
+    {
+        scan(first, last);
+    } else
+    {
+        scan(first, (size_t)((first_block + 1) * BLOCK_SIZE - oldest) - 1);
+        scan((size_t)(last_block * BLOCK_SIZE - oldest), last);
+        Range inner = QueryBlocks(first_block + 1, last_block - 1);
+        r.low = std::min(r.low, inner.low);
+        r.high = std::max(r.high, inner.high);
+    }
+
+    low = r.low;
+    high = r.high;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Models.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lowest low and highest high of a candle series over any time window, for
+// the chart's Y auto-fit. Candles are grouped by sequence number into blocks
+// of BLOCK_SIZE; a segment tree over a ring of block summaries answers the
+// whole blocks of a query and at most two partial blocks are scanned, so a
+// query is O(log n + BLOCK_SIZE) and the index takes 1/BLOCK_SIZE of the
+// series' memory.
+//
+// Sync follows a CandleSeries (or a snapshot copy of it) incrementally:
+// only blocks holding candles appended or changed since the last Sync are
+// recomputed. A series from another lineage is indexed from scratch.
+class CandleRangeIndex
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    void Sync(const CandleSeries& series);
+
+    // Returns false when no candle of the synced series lies in [t_min, t_max].
+    bool Query(const CandleSeries& series, double t_min, double t_max, Price& low, Price& high) const;
+
+private:
+    struct Range
+    {
+        Price low;
+        Price high;
+    };
+
+    uint64_t generation = 0;
+    size_t capacity = 0;
+    uint64_t synced = 0;
+    // Block b lives in leaf b % block_slots; leaves are padded to a power of two.
+    size_t block_slots = 0;
+    size_t leaf_count = 0;
+    std::vector<Range> tree;
+
+    void Reset(const CandleSeries& series);
+    void RebuildBlock(const CandleSeries& series, uint64_t block);
+    Range QueryBlocks(uint64_t first_block, uint64_t last_block) const;
+    Range QuerySlots(size_t first, size_t last) const;
+};
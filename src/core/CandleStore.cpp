@@ -0,0 +1,399 @@
+#include "CandleStore.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char DATA_MAGIC[8] = {'T', 'R', 'D', 'C', 'D', 'A', 'T', '1'};
+    constexpr char INDEX_MAGIC[8] = {'T', 'R', 'D', 'C', 'I', 'D', 'X', '1'};
+    constexpr size_t FILE_HEADER_SIZE = 16;
+    constexpr int COLUMN_COUNT = 6;
+    constexpr uint32_t TIME_AS_SECONDS = 1u << COLUMN_COUNT;
+
+    struct BlockHeader
+    {
+        uint32_t count;
+        uint32_t flags;
+    };
+
+    bool WriteHeader(int fd, const char* magic)
+    {
+        unsigned char header[FILE_HEADER_SIZE] = {};
+        std::memcpy(header, magic, 8);
+        uint32_t block_size = CANDLE_BLOCK_SIZE;
+        std::memcpy(header + 8, &block_size, sizeof(block_size));
+        return pwrite(fd, header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    }
+
+    bool CheckHeader(const unsigned char* header, const char* magic)
+    {
+        uint32_t block_size;
+        std::memcpy(&block_size, header + 8, sizeof(block_size));
+        return std::memcmp(header, magic, 8) == 0 && block_size == CANDLE_BLOCK_SIZE;
+    }
+
+    int64_t ColumnValue(const Candle& c, int column, bool time_as_seconds)
+    {
+        switch (column)
+        {
+            case 0:
+            {
+                if (time_as_seconds) return (int64_t)c.time;
+                int64_t bits;
+                std::memcpy(&bits, &c.time, sizeof(bits));
+                return bits;
+            }
+            case 1: return c.open;
+            case 2: return c.high;
+            case 3: return c.low;
+            case 4: return c.close;
+            default: return c.volume;
+        }
+    }
+
+    void SetColumnValue(Candle& c, int column, int64_t value, bool time_as_seconds)
+    {
+        switch (column)
+        {
+            case 0:
+                if (time_as_seconds) c.time = (double)value;
+                else std::memcpy(&c.time, &value, sizeof(value));
+                break;
+            case 1: c.open = value; break;
+            case 2: c.high = value; break;
+            case 3: c.low = value; break;
+            case 4: c.close = value; break;
+            default: c.volume = value; break;
+        }
+    }
+
+    template <typename T>
+    void Put(std::vector<unsigned char>& out, const T& value)
+    {
+        const unsigned char* p = (const unsigned char*)&value;
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    void EncodeBlock(const std::vector<Candle>& candles, bool delta_encode, std::vector<unsigned char>& out)
+    {
+        uint32_t count = (uint32_t)candles.size();
+        bool time_as_seconds = delta_encode;
+        for (const Candle& c : candles)
+        {
+            time_as_seconds = time_as_seconds && c.time == std::floor(c.time) && std::fabs(c.time) < 9e15;
+        }
+
+        out.clear();
+        BlockHeader header = {count, time_as_seconds ? TIME_AS_SECONDS : 0u};
+        Put(out, header);
+
+        for (int column = 0; column < COLUMN_COUNT; ++column)
+        {
+            bool use_delta = delta_encode && (column > 0 || time_as_seconds);
+            for (uint32_t i = 1; i < count && use_delta; ++i)
+            {
+                int64_t delta = ColumnValue(candles[i], column, time_as_seconds) - ColumnValue(candles[i - 1], column, time_as_seconds);
+                use_delta = delta >= INT32_MIN && delta <= INT32_MAX;
+            }
+
+            if (use_delta)
+            {
+                header.flags |= 1u << column;
+                Put(out, ColumnValue(candles[0], column, time_as_seconds));
+                for (uint32_t i = 1; i < count; ++i)
+                {
+                    int64_t delta = ColumnValue(candles[i], column, time_as_seconds) - ColumnValue(candles[i - 1], column, time_as_seconds);
+                    Put(out, (int32_t)delta);
+                }
+            } else
+            {
+                for (uint32_t i = 0; i < count; ++i) Put(out, ColumnValue(candles[i], column, time_as_seconds));
+            }
+        }
+        std::memcpy(out.data(), &header, sizeof(header));
+    }
+
+    size_t EncodedSize(const BlockHeader& header)
+    {
+        size_t size = sizeof(header);
+        for (int column = 0; column < COLUMN_COUNT; ++column)
+        {
+            bool delta = (header.flags & (1u << column)) != 0;
+            size += delta ? sizeof(int64_t) + (header.count - 1) * sizeof(int32_t) : header.count * sizeof(int64_t);
+        }
+        return size;
+    }
+
+    bool SameHeader(const unsigned char* p, const BlockHeader& header)
+    {
+        BlockHeader now;
+        std::memcpy(&now, p, sizeof(now));
+        return now.count == header.count && now.flags == header.flags;
+    }
+
+    // Decodes the size bytes at p, a block expected to hold count candles, into out.
+    // Fails when the header does not describe exactly that block, so bytes that
+    // changed under a reader are never decoded past size.
+    bool DecodeBlock(const unsigned char* p, size_t size, uint32_t count, std::vector<Candle>& out)
+    {
+        out.clear();
+        BlockHeader header;
+        if (size < sizeof(header)) return false;
+        const unsigned char* start = p;
+        std::memcpy(&header, p, sizeof(header));
+        if (header.count != count || count == 0 || count > CANDLE_BLOCK_SIZE || EncodedSize(header) != size) return false;
+        p += sizeof(header);
+
+        bool time_as_seconds = (header.flags & TIME_AS_SECONDS) != 0;
+        out.resize(header.count);
+
+        for (int column = 0; column < COLUMN_COUNT; ++column)
+        {
+            if (header.flags & (1u << column))
+            {
+                int64_t value;
+                std::memcpy(&value, p, sizeof(value));
+                p += sizeof(value);
+                SetColumnValue(out[0], column, value, time_as_seconds);
+
+                for (uint32_t i = 1; i < header.count; ++i)
+                {
+                    int32_t delta;
+                    std::memcpy(&delta, p, sizeof(delta));
+                    p += sizeof(delta);
+                    value += delta;
+                    SetColumnValue(out[i], column, value, time_as_seconds);
+                }
+            } else
+            {
+                for (uint32_t i = 0; i < header.count; ++i)
+                {
+                    int64_t value;
+                    std::memcpy(&value, p, sizeof(value));
+                    p += sizeof(value);
+                    SetColumnValue(out[i], column, value, time_as_seconds);
+                }
+            }
+        }
+
+        // The writer rewrites a partial block header first; a header that changed while
+        // decoding means the columns may be mixed.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!SameHeader(start, header))
+        {
+            out.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool ReadIndex(int fd, std::vector<CandleBlockInfo>& blocks)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < FILE_HEADER_SIZE) return false;
+
+        unsigned char header[FILE_HEADER_SIZE];
+        if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) || !CheckHeader(header, INDEX_MAGIC)) return false;
+
+        size_t count = ((size_t)st.st_size - FILE_HEADER_SIZE) / sizeof(CandleBlockInfo);
+        blocks.resize(count);
+        size_t bytes = count * sizeof(CandleBlockInfo);
+        return bytes == 0 || pread(fd, blocks.data(), bytes, FILE_HEADER_SIZE) == (ssize_t)bytes;
+    }
+}
+
+CandleStoreWriter::CandleStoreWriter() {}
+
+CandleStoreWriter::~CandleStoreWriter()
+{
+    Close();
+}
+
+bool CandleStoreWriter::Open(const std::string& path, bool delta)
+{
+    Close();
+    delta_encode = delta;
+
+    data_fd = ::open((path + ".cdat").c_str(), O_RDWR | O_CREAT, 0644);
+    index_fd = ::open((path + ".cidx").c_str(), O_RDWR | O_CREAT, 0644);
+
+    struct stat st;
+    if (data_fd == -1 || index_fd == -1 || fstat(index_fd, &st) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    std::vector<CandleBlockInfo> blocks;
+    if (st.st_size == 0)
+    {
+        if (!WriteHeader(data_fd, DATA_MAGIC) || !WriteHeader(index_fd, INDEX_MAGIC) || ftruncate(data_fd, FILE_HEADER_SIZE) != 0)
+        {
+            Close();
+            return false;
+        }
+    } else if (!ReadIndex(index_fd, blocks))
+    {
+        Close();
+        return false;
+    }
+
+    block_count = blocks.size();
+    last_time = blocks.empty() ? -std::numeric_limits<double>::infinity() : blocks.back().last_time;
+    pending_offset = blocks.empty() ? FILE_HEADER_SIZE : blocks.back().offset + blocks.back().bytes;
+    pending_indexed = false;
+    unflushed = 0;
+    pending.clear();
+    pending.reserve(CANDLE_BLOCK_SIZE);
+
+    // Reload a trailing partial block so new candles extend it.
+    if (!blocks.empty() && blocks.back().count < CANDLE_BLOCK_SIZE)
+    {
+        const CandleBlockInfo& last = blocks.back();
+        encoded.resize(last.bytes);
+        if (pread(data_fd, encoded.data(), last.bytes, (off_t)last.offset) != (ssize_t)last.bytes ||
+            !DecodeBlock(encoded.data(), last.bytes, last.count, pending))
+        {
+            Close();
+            return false;
+        }
+        pending_offset = last.offset;
+        pending_indexed = true;
+    }
+    return true;
+}
+
+void CandleStoreWriter::Close()
+{
+    if (data_fd != -1 && index_fd != -1) Flush();
+    if (data_fd != -1) ::close(data_fd);
+    if (index_fd != -1) ::close(index_fd);
+    data_fd = -1;
+    index_fd = -1;
+    pending.clear();
+    pending_indexed = false;
+    block_count = 0;
+}
+
+void CandleStoreWriter::Append(const Candle& candle)
+{
+    if (data_fd == -1 || candle.time <= last_time) return;
+
+    last_time = candle.time;
+    pending.push_back(candle);
+    if (pending.size() == CANDLE_BLOCK_SIZE || ++unflushed >= flush_interval) WriteBlock();
+}
+
+void CandleStoreWriter::Flush()
+{
+    if (data_fd != -1 && !pending.empty()) WriteBlock();
+}
+
+void CandleStoreWriter::WriteBlock()
+{
+    EncodeBlock(pending, delta_encode, encoded);
+
+    CandleBlockInfo info = {pending.front().time, pending.back().time, pending_offset, (uint32_t)pending.size(), (uint32_t)encoded.size()};
+    uint64_t entry = pending_indexed ? block_count - 1 : block_count;
+
+    bool ok = pwrite(data_fd, encoded.data(), encoded.size(), (off_t)pending_offset) == (ssize_t)encoded.size();
+    ok = ok && ftruncate(data_fd, (off_t)(pending_offset + encoded.size())) == 0;
+    ok = ok && pwrite(index_fd, &info, sizeof(info), (off_t)(FILE_HEADER_SIZE + entry * sizeof(info))) == (ssize_t)sizeof(info);
+    if (!ok) return;
+
+    if (!pending_indexed) block_count++;
+    unflushed = 0;
+
+    if (pending.size() == CANDLE_BLOCK_SIZE)
+    {
+        pending_offset += encoded.size();
+        pending.clear();
+        pending_indexed = false;
+    } else
+    {
+        pending_indexed = true;
+    }
+}
+
+CandleStore::CandleStore() {}
+
+CandleStore::~CandleStore()
+{
+    Close();
+}
+
+bool CandleStore::Open(const std::string& path)
+{
+    Close();
+
+    int index_fd = ::open((path + ".cidx").c_str(), O_RDONLY);
+    if (index_fd == -1) return false;
+    bool indexed = ReadIndex(index_fd, blocks);
+    ::close(index_fd);
+    if (!indexed) return false;
+
+    data_fd = ::open((path + ".cdat").c_str(), O_RDONLY);
+    struct stat st;
+    if (data_fd == -1 || fstat(data_fd, &st) != 0 || (size_t)st.st_size < FILE_HEADER_SIZE)
+    {
+        Close();
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, data_fd, 0);
+    if (p == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    data = (const unsigned char*)p;
+    data_size = (size_t)st.st_size;
+
+    // Drop index entries whose block is not fully on disk (writer interrupted mid-block).
+    while (!blocks.empty() && blocks.back().offset + blocks.back().bytes > data_size) blocks.pop_back();
+    if (!CheckHeader(data, DATA_MAGIC))
+    {
+        Close();
+        return false;
+    }
+
+    total = 0;
+    for (const auto& block : blocks) total += block.count;
+    return true;
+}
+
+void CandleStore::Close()
+{
+    if (data) munmap((void*)data, data_size);
+    if (data_fd != -1) ::close(data_fd);
+    data = nullptr;
+    data_fd = -1;
+    data_size = 0;
+    blocks.clear();
+    total = 0;
+}
+
+size_t CandleStore::Read(double from, double to, std::vector<Candle>& out) const
+{
+    if (!data || from > to) return 0;
+
+    auto first = std::lower_bound(blocks.begin(), blocks.end(), from, [](const CandleBlockInfo& b, double t) { return b.last_time < t; });
+
+    size_t before = out.size();
+    std::vector<Candle> block;
+    for (auto it = first; it != blocks.end() && it->first_time <= to; ++it)
+    {
+        if (it->offset + it->bytes > data_size || !DecodeBlock(data + it->offset, it->bytes, it->count, block)) continue;
+        auto lo = std::lower_bound(block.begin(), block.end(), from, [](const Candle& c, double t) { return c.time < t; });
+        auto hi = std::upper_bound(lo, block.end(), to, [](double t, const Candle& c) { return t < c.time; });
+        out.insert(out.end(), lo, hi);
+    }
+    return out.size() - before;
+}
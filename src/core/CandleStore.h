@@ -0,0 +1,98 @@
+#pragma once
+#include "Models.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk candle history in two files:
+//   <path>.cdat  blocks of up to CANDLE_BLOCK_SIZE candles, each block stored
+//                column by column (time, open, high, low, close, volume).
+//                A column is either raw 8-byte values or, when delta encoding
+//                is on and the values allow it, an 8-byte base followed by
+//                4-byte deltas to the previous value.
+//   <path>.cidx  one entry per block with its time span and file offset,
+//                the sparse index used to locate the blocks of a time range.
+// Only full blocks are final; the trailing partial block is rewritten in place every
+// flush_interval candles, so readers and a crash lose at most that many, and
+// when a writer reopens the store.
+constexpr size_t CANDLE_BLOCK_SIZE = 4096;
+
+struct CandleBlockInfo
+{
+    double first_time;
+    double last_time;
+    uint64_t offset;
+    uint32_t count;
+    uint32_t bytes;
+};
+
+class CandleStoreWriter
+{
+public:
+    CandleStoreWriter();
+    ~CandleStoreWriter();
+
+    CandleStoreWriter(const CandleStoreWriter&) = delete;
+    CandleStoreWriter& operator=(const CandleStoreWriter&) = delete;
+
+    // Opens or creates the store and continues after its last candle.
+    bool Open(const std::string& path, bool delta = true);
+    void Close();
+    bool IsOpen() const { return data_fd != -1; }
+
+    // Candles at or before the last stored time are ignored.
+    void Append(const Candle& candle);
+    // Writes the pending partial block so readers can see it.
+    void Flush();
+
+    uint64_t flush_interval = 256;
+
+private:
+    int data_fd = -1;
+    int index_fd = -1;
+    bool delta_encode = true;
+    uint64_t block_count = 0;
+    // The pending block starts at pending_offset; once flushed while partial
+    // it also has an index entry, which the next write replaces.
+    uint64_t pending_offset = 0;
+    bool pending_indexed = false;
+    // Candles appended since the pending block was last written.
+    uint64_t unflushed = 0;
+    double last_time = 0.0;
+    std::vector<Candle> pending;
+    std::vector<unsigned char> encoded;
+
+    void WriteBlock();
+};
+
+class CandleStore
+{
+public:
+    CandleStore();
+    ~CandleStore();
+
+    CandleStore(const CandleStore&) = delete;
+    CandleStore& operator=(const CandleStore&) = delete;
+
+    // Maps the store read-only; nothing is decoded until a range is read.
+    bool Open(const std::string& path);
+    void Close();
+
+    uint64_t Size() const { return total; }
+    bool Empty() const { return total == 0; }
+    double FirstTime() const { return blocks.empty() ? 0.0 : blocks.front().first_time; }
+    double LastTime() const { return blocks.empty() ? 0.0 : blocks.back().last_time; }
+    size_t BlockCount() const { return blocks.size(); }
+
+    // Appends the candles with from <= time <= to, touching only the blocks that overlap the range.
+    // A partial block the writer has rewritten since Open is skipped; reopen to see its new candles.
+    size_t Read(double from, double to, std::vector<Candle>& out) const;
+
+private:
+    int data_fd = -1;
+    const unsigned char* data = nullptr;
+    size_t data_size = 0;
+    std::vector<CandleBlockInfo> blocks;
+    uint64_t total = 0;
+};
@@ -0,0 +1,371 @@
+#include "EngineThread.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <unistd.h>
+
+EngineThread::EngineThread() {}
+
+EngineThread::~EngineThread()
+{
+    Stop();
+}
+
+int EngineThread::AddSymbol(const Instrument& instrument, double initial_price)
+{
+    if (running) return -1;
+
+    auto shard = std::make_unique<Shard>();
+    shard->initial_price = initial_price;
+    shard->engine.state.instrument = instrument;
+    shard->engine.state.current_price = instrument.ToTicks(initial_price);
+
+    instruments.push_back(instrument);
+    shards.push_back(std::move(shard));
+    return (int)shards.size() - 1;
+}
+
+void EngineThread::SetExternalVenue(int symbol_id, MarketDataSource* source, OrderGateway* gateway)
+{
+    if (running || symbol_id < 0 || symbol_id >= (int)shards.size()) return;
+    shards[symbol_id]->source = source;
+    shards[symbol_id]->gateway = gateway;
+}
+
+void EngineThread::Start(const std::string& journal_path, int worker_count)
+{
+    if (running) return;
+    if (shards.empty())
+    {
+        TradingState defaults;
+        AddSymbol(defaults.instrument, defaults.instrument.ToPrice((double)defaults.current_price));
+    }
+
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        Shard& shard = *shards[i];
+        TradingEngine& engine = shard.engine;
+
+        bool restored = false;
+        if (shard.source)
+        {
+            // Replaying a journal would not reproduce an external market.
+            engine.SetMarketDataSource(shard.source);
+            engine.SetOrderGateway(shard.gateway);
+        }
+        else if (!journal_path.empty())
+        {
+            std::string path = (i == 0) ? journal_path : journal_path + "." + std::to_string(i);
+            bool exists = ::access(path.c_str(), F_OK) == 0;
+            ReplayStats stats;
+            bool replayed = exists && ReplayJournal(path, engine, stats);
+            restored = replayed && stats.events > 0;
+
+            bool journaled = true;
+            if (!restored)
+            {
+                engine = TradingEngine();
+                engine.state.instrument = instruments[i];
+                engine.state.current_price = instruments[i].ToTicks(shard.initial_price);
+
+                // Only an empty journal may be started over; anything else is the account's history.
+                if (exists && !replayed)
+                {
+                    std::string aside = SetAsideJournal(path);
+                    const char* reason = stats.diverged ? "diverged on replay" : "could not be read";
+                    if (aside.empty())
+                    {
+                        std::fprintf(stderr, "journal %s %s and could not be moved aside; %s runs without a journal\n",
+                            path.c_str(), reason, instruments[i].symbol);
+                        journaled = false;
+                    } else
+                    {
+                        std::fprintf(stderr, "journal %s %s after %llu events; kept as %s, %s starts a new account\n",
+                            path.c_str(), reason, (unsigned long long)stats.events, aside.c_str(), instruments[i].symbol);
+                    }
+                }
+            }
+            if (journaled && shard.journal.Open(path, !restored)) engine.SetJournal(&shard.journal);
+        }
+
+        if (!restored) engine.Init();
+        PublishSnapshot(shard);
+        PublishAccount(shard);
+    }
+
+    if (worker_count <= 0) worker_count = (int)std::max(1u, std::thread::hardware_concurrency());
+    worker_count = std::min(worker_count, (int)shards.size());
+
+    worker_states.clear();
+    for (int w = 0; w < worker_count; ++w) worker_states.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < shards.size(); ++i) shards[i]->worker = (int)i % worker_count;
+
+    running = true;
+    for (int w = 0; w < worker_count; ++w)
+    {
+        workers.emplace_back(&EngineThread::Run, this, w, worker_count);
+    }
+}
+
+void EngineThread::Stop()
+{
+    running = false;
+    for (int w = 0; w < (int)worker_states.size(); ++w) Signal(w);
+    for (auto& worker : workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+
+    for (auto& shard : shards)
+    {
+        shard->engine.SetJournal(nullptr);
+        shard->journal.Close();
+    }
+}
+
+void EngineThread::SetWakeCallback(std::function<void()> callback)
+{
+    if (!running) wake = std::move(callback);
+}
+
+void EngineThread::SetActiveSymbol(int symbol_id)
+{
+    if (symbol_id < 0 || symbol_id >= (int)shards.size()) return;
+    active_symbol.store(symbol_id, std::memory_order_relaxed);
+    // Its worker publishes the newly active symbol's snapshot on the next pass.
+    if (!worker_states.empty()) Signal(shards[symbol_id]->worker);
+}
+
+const TradingState& EngineThread::AcquireSnapshot()
+{
+    Shard& shard = *shards[ActiveSymbol()];
+    shard.snapshots.Consume();
+    return shard.snapshots.ReadBuffer();
+}
+
+AccountSummary EngineThread::AggregateAccount()
+{
+    AccountSummary total;
+    for (auto& shard : shards)
+    {
+        shard->account.Consume();
+        const AccountSummary& a = shard->account.ReadBuffer();
+        total.balance += a.balance;
+        total.equity += a.equity;
+        total.unrealized_pnl += a.unrealized_pnl;
+        total.realized_pnl += a.realized_pnl;
+        total.open_orders += a.open_orders;
+        total.total_trades += a.total_trades;
+        total.winning_trades += a.winning_trades;
+    }
+    return total;
+}
+
+void EngineThread::PlaceOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_PLACE_ORDER;
+    cmd.is_buy = is_buy;
+    cmd.order_type = order_type;
+    cmd.price = price;
+    cmd.amount = amount;
+    cmd.reduce_only = reduce_only;
+    cmd.submit_ns = MonotonicNanos();
+    SubmitActive(cmd);
+}
+
+void EngineThread::CancelOrder(int order_id)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_CANCEL_ORDER;
+    cmd.order_id = order_id;
+    SubmitActive(cmd);
+}
+
+void EngineThread::ModifyOrder(int order_id, Qty new_amount)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_MODIFY_ORDER;
+    cmd.order_id = order_id;
+    cmd.amount = new_amount;
+    SubmitActive(cmd);
+}
+
+void EngineThread::CancelAllOrders()
+{
+    EngineCommand cmd;
+    cmd.type = CMD_CANCEL_ALL;
+    SubmitActive(cmd);
+}
+
+void EngineThread::CancelOrders(bool is_buy)
+{
+    CancelOrders(is_buy, -std::numeric_limits<Price>::max(), std::numeric_limits<Price>::max());
+}
+
+void EngineThread::CancelOrders(bool is_buy, Price low, Price high)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_CANCEL_RANGE;
+    cmd.is_buy = is_buy;
+    cmd.price = low;
+    cmd.price_high = high;
+    SubmitActive(cmd);
+}
+
+void EngineThread::ClosePosition(bool close_long, bool close_short)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_CLOSE_POSITION;
+    cmd.close_long = close_long;
+    cmd.close_short = close_short;
+    SubmitActive(cmd);
+}
+
+void EngineThread::SetPaused(bool paused)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_SET_PAUSED;
+    cmd.paused = paused;
+    for (auto& shard : shards) Submit(*shard, cmd);
+}
+
+void EngineThread::SetSimulationInterval(double interval_s)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_SET_INTERVAL;
+    cmd.interval_s = interval_s;
+    for (auto& shard : shards) Submit(*shard, cmd);
+}
+
+void EngineThread::SetTicksPerCandle(int ticks)
+{
+    EngineCommand cmd;
+    cmd.type = CMD_SET_TICKS;
+    cmd.ticks_per_candle = ticks;
+    for (auto& shard : shards) Submit(*shard, cmd);
+}
+
+void EngineThread::Submit(Shard& shard, const EngineCommand& cmd)
+{
+    // Before Start the command waits in the queue for the first pass of the worker loop.
+    bool started = !worker_states.empty();
+    while (!shard.commands.TryPush(cmd))
+    {
+        if (started) Signal(shard.worker);
+        std::this_thread::yield();
+    }
+    if (started) Signal(shard.worker);
+}
+
+void EngineThread::Signal(int worker_index)
+{
+    Worker& worker = *worker_states[worker_index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.signalled = true;
+    }
+    worker.wake.notify_one();
+}
+
+void EngineThread::SubmitActive(const EngineCommand& cmd)
+{
+    Submit(*shards[ActiveSymbol()], cmd);
+}
+
+void EngineThread::ApplyCommand(Shard& shard, const EngineCommand& cmd)
+{
+    TradingEngine& engine = shard.engine;
+    switch (cmd.type)
+    {
+        case CMD_PLACE_ORDER: engine.PlaceOrder(cmd.is_buy, cmd.order_type, cmd.price, cmd.amount, cmd.reduce_only, cmd.submit_ns); break;
+        case CMD_CANCEL_ORDER: engine.CancelOrder(cmd.order_id); break;
+        case CMD_MODIFY_ORDER: engine.ModifyOrder(cmd.order_id, cmd.amount); break;
+        case CMD_CANCEL_ALL: engine.CancelAllOrders(); break;
+        case CMD_CANCEL_RANGE: engine.CancelOrders(cmd.is_buy, cmd.price, cmd.price_high); break;
+        case CMD_CLOSE_POSITION: engine.ClosePosition(cmd.close_long, cmd.close_short); break;
+        case CMD_SET_PAUSED: engine.SetPaused(cmd.paused); break;
+        case CMD_SET_INTERVAL: engine.SetSimulationInterval(cmd.interval_s); break;
+        case CMD_SET_TICKS: engine.SetTicksPerCandle(cmd.ticks_per_candle); break;
+        default: break;
+    }
+}
+
+void EngineThread::PublishSnapshot(Shard& shard)
+{
+    shard.engine.SummarizeLatency();
+    shard.engine.state.version = snapshot_version.fetch_add(1, std::memory_order_acq_rel) + 1;
+    shard.snapshots.WriteBuffer() = shard.engine.state;
+    shard.snapshots.Publish();
+    shard.snapshot_current = true;
+}
+
+void EngineThread::PublishAccount(Shard& shard)
+{
+    const TradingState& state = shard.engine.state;
+    const Instrument& inst = state.instrument;
+
+    AccountSummary& a = shard.account.WriteBuffer();
+    a.balance = inst.ToValue(state.balance);
+    a.equity = inst.ToValue(state.equity);
+    a.unrealized_pnl = inst.ToValue(state.long_pos.unrealized_pnl + state.short_pos.unrealized_pnl);
+    a.realized_pnl = inst.ToValue(state.gross_profit - state.gross_loss);
+    a.open_orders = (int)state.open_orders.size();
+    a.total_trades = state.total_trades_count;
+    a.winning_trades = state.winning_trades;
+    shard.account.Publish();
+}
+
+void EngineThread::Run(int worker_index, int worker_count)
+{
+    using clock = std::chrono::steady_clock;
+    auto last_time = clock::now();
+    Worker& worker = *worker_states[worker_index];
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        auto now = clock::now();
+        double dt = std::chrono::duration<double>(now - last_time).count();
+        last_time = now;
+        int active = ActiveSymbol();
+
+        double next_tick = std::numeric_limits<double>::infinity();
+
+        for (size_t i = worker_index; i < shards.size(); i += worker_count)
+        {
+            Shard& shard = *shards[i];
+            bool dirty = false;
+
+            EngineCommand cmd;
+            while (shard.commands.TryPop(cmd))
+            {
+                ApplyCommand(shard, cmd);
+                dirty = true;
+            }
+
+            if (shard.engine.Update(dt)) dirty = true;
+
+            // Only the symbol on screen pays for full snapshots; the rest publish their account.
+            if (dirty)
+            {
+                PublishAccount(shard);
+                shard.snapshot_current = false;
+            }
+            if ((int)i == active && !shard.snapshot_current)
+            {
+                PublishSnapshot(shard);
+                if (wake) wake();
+            }
+            next_tick = std::min(next_tick, shard.engine.TimeToNextUpdate());
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        auto woken = [&] { return worker.signalled || !running.load(std::memory_order_relaxed); };
+        if (std::isinf(next_tick)) worker.wake.wait(lock, woken);
+        else worker.wake.wait_for(lock, std::chrono::duration<double>(next_tick), woken);
+        worker.signalled = false;
+    }
+}
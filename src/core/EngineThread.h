@@ -0,0 +1,108 @@
+#pragma once
+#include "TradingEngine.h"
+#include "Journal.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs one TradingEngine shard per symbol on a pool of worker threads. Each
+// shard has its own book, candles, orders and sub-account and is only ever
+// touched by the worker that owns it. The UI thread submits commands through
+// a lock-free queue per shard and reads immutable TradingState snapshots of
+// the active symbol; account summaries of every shard are published through
+// their own triple buffers, so aggregation never takes a lock.
+class EngineThread
+{
+public:
+    EngineThread();
+    ~EngineThread();
+
+    // Symbols must be added before Start. Without any, Start adds the default instrument.
+    int AddSymbol(const Instrument& instrument, double initial_price);
+    int SymbolCount() const { return (int)instruments.size(); }
+    // Takes a symbol's market data from source and sends its orders to gateway (neither
+    // owned) instead of simulating them. Set before Start; such a symbol is not journaled.
+    void SetExternalVenue(int symbol_id, MarketDataSource* source, OrderGateway* gateway);
+    const Instrument& GetInstrument(int symbol_id) const { return instruments[symbol_id]; }
+
+    // worker_count 0 uses one worker per hardware thread, capped at the symbol count.
+    // With a journal path, each shard restores from its own journal (path, then
+    // path.1, path.2, ...) and appends every later input event to it. A journal
+    // that cannot be replayed is renamed aside (see SetAsideJournal) and reported on stderr.
+    void Start(const std::string& journal_path = std::string(), int worker_count = 0);
+    void Stop();
+
+    void SetActiveSymbol(int symbol_id);
+    int ActiveSymbol() const { return active_symbol.load(std::memory_order_relaxed); }
+
+    // Called from a worker thread whenever the active symbol publishes a new
+    // snapshot, e.g. to wake a UI thread blocked waiting for events. Set before Start.
+    void SetWakeCallback(std::function<void()> callback);
+    // Version of the newest snapshot being published. A reader whose snapshot has
+    // an older version will see a newer one (and be woken) shortly.
+    uint64_t SnapshotVersion() const { return snapshot_version.load(std::memory_order_acquire); }
+
+    // Snapshot of the active symbol.
+    const TradingState& AcquireSnapshot();
+    AccountSummary AggregateAccount();
+
+    // Order commands go to the active symbol; pause and interval apply to all symbols.
+    void PlaceOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only = false);
+    void CancelOrder(int order_id);
+    void ModifyOrder(int order_id, Qty new_amount);
+    void CancelAllOrders();
+    void CancelOrders(bool is_buy);
+    void CancelOrders(bool is_buy, Price low, Price high);
+    void ClosePosition(bool close_long, bool close_short);
+    void SetPaused(bool paused);
+    void SetSimulationInterval(double interval_s);
+    void SetTicksPerCandle(int ticks);
+
+private:
+    struct Shard
+    {
+        TradingEngine engine;
+        JournalWriter journal;
+        TripleBuffer<TradingState> snapshots;
+        TripleBuffer<AccountSummary> account;
+        SpscQueue<EngineCommand, 1024> commands;
+        double initial_price = 0.0;
+        bool snapshot_current = false;
+        MarketDataSource* source = nullptr;
+        OrderGateway* gateway = nullptr;
+        int worker = 0;
+    };
+
+    // A worker sleeps until a command is pushed to one of its shards or the
+    // earliest of their next ticks is due; paused shards have none.
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool signalled = false;
+    };
+
+    std::vector<Instrument> instruments;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Worker>> worker_states;
+    std::atomic<bool> running{false};
+    std::atomic<int> active_symbol{0};
+    std::atomic<uint64_t> snapshot_version{0};
+    std::function<void()> wake;
+
+    void Run(int worker_index, int worker_count);
+    void Signal(int worker_index);
+    void Submit(Shard& shard, const EngineCommand& cmd);
+    void SubmitActive(const EngineCommand& cmd);
+    void ApplyCommand(Shard& shard, const EngineCommand& cmd);
+    void PublishSnapshot(Shard& shard);
+    void PublishAccount(Shard& shard);
+};
@@ -0,0 +1,540 @@
+#include "FeedHandler.h"
+#include "TradingEngine.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr uint32_t PACKET_MAGIC = 0x46495554;    // "TUIF"
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x53495554;  // "TUIS"
+    constexpr const char* FEED_INTERFACE = "127.0.0.1";
+    constexpr int SNAPSHOT_TIMEOUT_MS = 1000;
+
+    sockaddr_in MakeAddress(uint32_t addr, uint16_t port)
+    {
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = addr;
+        a.sin_port = port;
+        return a;
+    }
+
+    bool SendAll(int fd, const void* data, size_t size)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        while (size > 0)
+        {
+            ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    void SetTimeouts(int fd, int timeout_ms)
+    {
+        timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+}
+
+FeedPublisher::FeedPublisher() : recent_candles(FEED_SNAPSHOT_CANDLES) {}
+
+FeedPublisher::~FeedPublisher()
+{
+    Close();
+}
+
+bool FeedPublisher::Open(const std::string& group, uint16_t port, uint16_t snapshot_port)
+{
+    Close();
+
+    in_addr group_in, iface;
+    if (inet_pton(AF_INET, group.c_str(), &group_in) != 1 || inet_pton(AF_INET, FEED_INTERFACE, &iface) != 1) return false;
+
+    udp_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_fd == -1) return false;
+    unsigned char loop = 1;
+    setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+    setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    group_addr = group_in.s_addr;
+    group_port = htons(port);
+
+    listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    sockaddr_in snapshot_addr = MakeAddress(iface.s_addr, htons(snapshot_port));
+    if (listen_fd == -1 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        ::bind(listen_fd, (const sockaddr*)&snapshot_addr, sizeof(snapshot_addr)) != 0 || ::listen(listen_fd, 8) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    pending = 0;
+    next_seq = 1;
+    candles_published = 0;
+    packets_sent = packets_dropped = snapshots_served = 0;
+    bids.clear();
+    asks.clear();
+    recent_candles.Clear();
+    return true;
+}
+
+void FeedPublisher::Close()
+{
+    if (udp_fd != -1) ::close(udp_fd);
+    if (listen_fd != -1) ::close(listen_fd);
+    udp_fd = -1;
+    listen_fd = -1;
+}
+
+void FeedPublisher::WriteCandle(const Candle& candle)
+{
+    recent_candles.PushBack(candle);
+    candles_published++;
+
+    MarketRecord r = {};
+    r.time = candle.time;
+    r.type = MD_CANDLE;
+    r.price = candle.open;
+    r.high = candle.high;
+    r.low = candle.low;
+    r.close = candle.close;
+    r.volume = candle.volume;
+    Append(r);
+}
+
+void FeedPublisher::WriteTrade(const Trade& trade)
+{
+    MarketRecord r = {};
+    r.time = trade.time;
+    r.type = MD_TRADE;
+    r.is_buy = trade.is_buy ? 1 : 0;
+    r.price = trade.price;
+    r.volume = trade.amount;
+    Append(r);
+}
+
+void FeedPublisher::WriteBook(double time, bool is_bid, Price price, Qty volume)
+{
+    auto& levels = is_bid ? bids : asks;
+    if (volume > 0) levels[price] = volume;
+    else levels.erase(price);
+
+    MarketRecord r = {};
+    r.time = time;
+    r.type = MD_BOOK;
+    r.is_buy = is_bid ? 1 : 0;
+    r.price = price;
+    r.volume = volume;
+    Append(r);
+}
+
+void FeedPublisher::Append(const MarketRecord& record)
+{
+    if (pending == FEED_RECORDS_PER_PACKET) SendPacket(0);
+    std::memcpy(packet + sizeof(FeedPacketHeader) + pending * sizeof(MarketRecord), &record, sizeof(record));
+    pending++;
+    next_seq++;
+}
+
+void FeedPublisher::SendPacket(uint16_t flags)
+{
+    if (udp_fd == -1) return;
+
+    FeedPacketHeader header = {PACKET_MAGIC, (uint16_t)pending, flags, next_seq - pending};
+    std::memcpy(packet, &header, sizeof(header));
+    size_t size = sizeof(header) + pending * sizeof(MarketRecord);
+    pending = 0;
+
+    bool drop = drop_every > 0 && flags == 0 && (packets_sent + packets_dropped + 1) % (uint64_t)drop_every == 0;
+    sockaddr_in dest = MakeAddress(group_addr, group_port);
+    if (drop || ::sendto(udp_fd, packet, size, 0, (const sockaddr*)&dest, sizeof(dest)) != (ssize_t)size)
+    {
+        packets_dropped++;
+        return;
+    }
+    packets_sent++;
+}
+
+void FeedPublisher::Flush()
+{
+    if (pending > 0) SendPacket(0);
+    ServeSnapshots();
+}
+
+void FeedPublisher::Finish()
+{
+    Flush();
+    SendPacket(FEED_END_OF_SESSION);
+}
+
+void FeedPublisher::ServeSnapshots()
+{
+    if (listen_fd == -1) return;
+
+    for (;;)
+    {
+        int client = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client == -1) return;
+        SetTimeouts(client, SNAPSHOT_TIMEOUT_MS);
+
+        // Candles go first, so replaying them cannot match against the fresh book.
+        snapshot.clear();
+        for (size_t i = 0; i < recent_candles.Size(); ++i)
+        {
+            const Candle& c = recent_candles[i];
+            MarketRecord r = {};
+            r.time = c.time;
+            r.type = MD_CANDLE;
+            r.price = c.open;
+            r.high = c.high;
+            r.low = c.low;
+            r.close = c.close;
+            r.volume = c.volume;
+            snapshot.push_back(r);
+        }
+        auto add_levels = [&](const std::map<Price, Qty>& levels, bool is_bid)
+        {
+            for (const auto& level : levels)
+            {
+                MarketRecord r = {};
+                r.type = MD_BOOK;
+                r.is_buy = is_bid ? 1 : 0;
+                r.price = level.first;
+                r.volume = level.second;
+                snapshot.push_back(r);
+            }
+        };
+        add_levels(bids, true);
+        add_levels(asks, false);
+        if (snapshot.size() > FEED_MAX_SNAPSHOT) snapshot.resize(FEED_MAX_SNAPSHOT);
+
+        FeedSnapshotHeader header = {SNAPSHOT_MAGIC, (uint32_t)snapshot.size(), LastSeq(), candles_published - recent_candles.Size()};
+        if (SendAll(client, &header, sizeof(header)) && SendAll(client, snapshot.data(), snapshot.size() * sizeof(MarketRecord)))
+        {
+            snapshots_served++;
+        }
+        ::close(client);
+    }
+}
+
+struct FeedHandler::Batch
+{
+    mmsghdr messages[BATCH];
+    iovec vectors[BATCH];
+    unsigned char buffers[BATCH][FEED_MAX_PACKET];
+
+    // Ring of packets received while a snapshot is in flight.
+    unsigned char held[HOLD_PACKETS][FEED_MAX_PACKET];
+    uint16_t held_sizes[HOLD_PACKETS];
+};
+
+FeedHandler::FeedHandler() {}
+
+FeedHandler::~FeedHandler()
+{
+    Close();
+}
+
+bool FeedHandler::Open(const std::string& group, uint16_t port, uint16_t snapshot_port)
+{
+    Close();
+
+    in_addr group_in, iface;
+    if (inet_pton(AF_INET, group.c_str(), &group_in) != 1 || inet_pton(AF_INET, FEED_INTERFACE, &iface) != 1) return false;
+
+    fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+
+    // Several receivers may share the group; a large buffer rides out scheduling hiccups.
+    int one = 1;
+    int buffer_size = 8 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+    sockaddr_in addr = MakeAddress(group_in.s_addr, htons(port));
+    if (::bind(fd, (const sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        Close();
+        return false;
+    }
+    if (IN_MULTICAST(ntohl(group_in.s_addr)))
+    {
+        ip_mreq membership = {};
+        membership.imr_multiaddr = group_in;
+        membership.imr_interface = iface;
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    batch.reset(new Batch());
+    for (int i = 0; i < BATCH; ++i)
+    {
+        batch->vectors[i] = {batch->buffers[i], FEED_MAX_PACKET};
+        batch->messages[i].msg_hdr.msg_iov = &batch->vectors[i];
+        batch->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    snapshot.resize(FEED_MAX_SNAPSHOT);
+
+    this->snapshot_port = snapshot_port;
+    expected_seq = 1;
+    resync = false;
+    candles_applied = 0;
+    ended = false;
+    stats = FeedStats();
+    held_first = held_count = 0;
+    return true;
+}
+
+void FeedHandler::Close()
+{
+    if (fd != -1) ::close(fd);
+    if (snapshot_fd != -1) ::close(snapshot_fd);
+    fd = -1;
+    snapshot_fd = -1;
+    recovery = RECOVERY_NONE;
+}
+
+bool FeedHandler::Advance(TradingEngine& engine)
+{
+    if (fd == -1 || ended) return false;
+
+    int timeout_ms = poll_timeout_ms;
+    pollfd fds[2] = {{fd, POLLIN, 0}, {snapshot_fd, (short)(recovery == RECOVERY_CONNECTING ? POLLOUT : POLLIN), 0}};
+    int count = 1;
+    if (recovery != RECOVERY_NONE)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(recovery_deadline - std::chrono::steady_clock::now());
+        timeout_ms = std::max(0, std::min(timeout_ms, (int)left.count() + 1));
+        count = 2;
+    }
+    if (::poll(fds, count, timeout_ms) < 0) return true;
+
+    if (recovery != RECOVERY_NONE) ContinueRecovery(engine, fds[1].revents);
+
+    if (fds[0].revents & POLLIN)
+    {
+        int received = ::recvmmsg(fd, batch->messages, BATCH, MSG_DONTWAIT, nullptr);
+        for (int i = 0; i < received; ++i)
+        {
+            const unsigned char* data = batch->buffers[i];
+            size_t size = batch->messages[i].msg_len;
+            if (recovery != RECOVERY_NONE || !ProcessPacket(engine, data, size)) Hold(data, size);
+        }
+    }
+    return true;
+}
+
+bool FeedHandler::ProcessPacket(TradingEngine& engine, const unsigned char* data, size_t size)
+{
+    FeedPacketHeader header;
+    if (size < sizeof(header)) return true;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != PACKET_MAGIC || size < sizeof(header) + header.count * sizeof(MarketRecord)) return true;
+
+    if (resync)
+    {
+        // The book stays stale until a later recovery succeeds.
+        expected_seq = std::max(expected_seq, header.first_seq);
+        resync = false;
+    }
+    if (header.first_seq > expected_seq)
+    {
+        stats.gaps++;
+        StartRecovery();
+        return false;
+    }
+    stats.packets++;
+
+    const unsigned char* records = data + sizeof(header);
+    for (uint16_t i = 0; i < header.count; ++i)
+    {
+        uint64_t seq = header.first_seq + i;
+        if (seq < expected_seq)
+        {
+            stats.stale++;
+            continue;
+        }
+        MarketRecord record;
+        std::memcpy(&record, records + i * sizeof(MarketRecord), sizeof(record));
+        Apply(engine, record);
+        stats.messages++;
+        expected_seq = seq + 1;
+    }
+
+    if (header.flags & FEED_END_OF_SESSION) ended = true;
+    return true;
+}
+
+void FeedHandler::Apply(TradingEngine& engine, const MarketRecord& record)
+{
+    ApplyMarketRecord(engine, record);
+    if (record.type == MD_CANDLE) candles_applied++;
+}
+
+void FeedHandler::Hold(const unsigned char* data, size_t size)
+{
+    if (held_count == HOLD_PACKETS)
+    {
+        // The newest packets are the ones a snapshot will not cover.
+        held_first = (held_first + 1) % HOLD_PACKETS;
+        held_count--;
+        stats.held_dropped++;
+    }
+    size_t slot = (held_first + held_count) % HOLD_PACKETS;
+    std::memcpy(batch->held[slot], data, size);
+    batch->held_sizes[slot] = (uint16_t)size;
+    held_count++;
+}
+
+void FeedHandler::DrainHeld(TradingEngine& engine)
+{
+    while (held_count > 0 && recovery == RECOVERY_NONE)
+    {
+        if (!ProcessPacket(engine, batch->held[held_first], batch->held_sizes[held_first])) return;
+        held_first = (held_first + 1) % HOLD_PACKETS;
+        held_count--;
+    }
+}
+
+void FeedHandler::StartRecovery()
+{
+    recovery_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SNAPSHOT_TIMEOUT_MS);
+    snapshot_received = 0;
+
+    snapshot_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    in_addr iface;
+    inet_pton(AF_INET, FEED_INTERFACE, &iface);
+    sockaddr_in addr = MakeAddress(iface.s_addr, htons(snapshot_port));
+    if (snapshot_fd == -1 || (::connect(snapshot_fd, (const sockaddr*)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS))
+    {
+        // Failed outright: nothing is held yet, so the feed simply resyncs.
+        if (snapshot_fd != -1) ::close(snapshot_fd);
+        snapshot_fd = -1;
+        stats.failed_recoveries++;
+        resync = true;
+        return;
+    }
+    recovery = RECOVERY_CONNECTING;
+}
+
+void FeedHandler::ContinueRecovery(TradingEngine& engine, short events)
+{
+    if (std::chrono::steady_clock::now() >= recovery_deadline)
+    {
+        FinishRecovery(engine, false);
+        return;
+    }
+
+    if (recovery == RECOVERY_CONNECTING)
+    {
+        if (!(events & (POLLOUT | POLLERR | POLLHUP))) return;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(snapshot_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0)
+        {
+            FinishRecovery(engine, false);
+            return;
+        }
+        recovery = RECOVERY_RECEIVING;
+        return;
+    }
+
+    if (!(events & (POLLIN | POLLERR | POLLHUP))) return;
+    const size_t header_size = sizeof(FeedSnapshotHeader);
+    for (;;)
+    {
+        size_t total = header_size;
+        if (snapshot_received >= header_size)
+        {
+            if (snapshot_header.magic != SNAPSHOT_MAGIC || snapshot_header.count > snapshot.size())
+            {
+                FinishRecovery(engine, false);
+                return;
+            }
+            total += snapshot_header.count * sizeof(MarketRecord);
+            if (snapshot_received == total)
+            {
+                FinishRecovery(engine, true);
+                return;
+            }
+        }
+
+        unsigned char* dest = (snapshot_received < header_size)
+            ? (unsigned char*)&snapshot_header + snapshot_received
+            : (unsigned char*)snapshot.data() + (snapshot_received - header_size);
+        size_t want = (snapshot_received < header_size) ? header_size - snapshot_received : total - snapshot_received;
+
+        ssize_t n = ::recv(snapshot_fd, dest, want, 0);
+        if (n > 0)
+        {
+            snapshot_received += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        FinishRecovery(engine, false);
+        return;
+    }
+}
+
+void FeedHandler::FinishRecovery(TradingEngine& engine, bool received)
+{
+    ::close(snapshot_fd);
+    snapshot_fd = -1;
+    recovery = RECOVERY_NONE;
+
+    if (received)
+    {
+        ApplySnapshot(engine);
+    } else
+    {
+        stats.failed_recoveries++;
+        resync = true;
+    }
+    DrainHeld(engine);
+}
+
+void FeedHandler::ApplySnapshot(TradingEngine& engine)
+{
+    // Candles published between the last one applied and the snapshot's first are gone.
+    uint64_t lost = (snapshot_header.first_candle > candles_applied) ? snapshot_header.first_candle - candles_applied : 0;
+    uint64_t candle_index = snapshot_header.first_candle;
+
+    engine.ClearFeedBook();
+    for (uint32_t i = 0; i < snapshot_header.count; ++i)
+    {
+        const MarketRecord& record = snapshot[i];
+        if (record.type == MD_CANDLE)
+        {
+            // Candles the engine already has are skipped.
+            if (candle_index++ < candles_applied) continue;
+            candles_applied = candle_index - 1;
+        }
+        Apply(engine, record);
+    }
+    expected_seq = snapshot_header.last_seq + 1;
+
+    if (lost > 0)
+    {
+        stats.candles_lost += lost;
+        stats.failed_recoveries++;
+    } else
+    {
+        stats.recoveries++;
+    }
+}
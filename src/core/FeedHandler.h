@@ -0,0 +1,200 @@
+#pragma once
+#include "MarketDataSource.h"
+#include "Models.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Market data feed over UDP multicast with TCP snapshot recovery.
+//
+// Packets carry up to FEED_RECORDS_PER_PACKET MarketRecords numbered with
+// consecutive sequence numbers (the first is 1). A receiver that sees a
+// sequence number beyond the one it expects has missed packets: it fetches
+// a snapshot over TCP (every book level plus the last FEED_SNAPSHOT_CANDLES
+// candles, as of a given sequence number), applies it and resumes with the
+// packets after it. Trades inside a gap are not recovered, nor are candles
+// older than the snapshot's; those are counted as lost. Both ends run on
+// one host (the multicast interface and the snapshot server are on loopback)
+// and use host byte order.
+
+enum FeedPacketFlags : uint16_t
+{
+    FEED_END_OF_SESSION = 1
+};
+
+struct FeedPacketHeader
+{
+    uint32_t magic;
+    uint16_t count;
+    uint16_t flags;
+    uint64_t first_seq;
+};
+
+struct FeedSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t count;
+    uint64_t last_seq;
+    // Number of candles published before the snapshot's first one.
+    uint64_t first_candle;
+};
+
+static_assert(sizeof(FeedPacketHeader) == 16, "feed packet header must stay 16 bytes");
+static_assert(sizeof(FeedSnapshotHeader) == 24, "feed snapshot header must stay 24 bytes");
+
+// Sized to fit an Ethernet MTU without fragmentation.
+constexpr size_t FEED_MAX_PACKET = 1472;
+constexpr size_t FEED_RECORDS_PER_PACKET = (FEED_MAX_PACKET - sizeof(FeedPacketHeader)) / sizeof(MarketRecord);
+constexpr size_t FEED_SNAPSHOT_CANDLES = 1024;
+constexpr size_t FEED_MAX_SNAPSHOT = 16384;
+
+struct FeedStats
+{
+    uint64_t packets = 0;
+    uint64_t messages = 0;
+    uint64_t gaps = 0;
+    // A recovery succeeds when its snapshot covers every candle missed in the gap.
+    uint64_t recoveries = 0;
+    uint64_t failed_recoveries = 0;
+    uint64_t candles_lost = 0;
+    // Messages at or before the last applied snapshot, dropped as duplicates.
+    uint64_t stale = 0;
+    // Packets that arrived during a recovery and did not fit the hold buffer.
+    uint64_t held_dropped = 0;
+};
+
+// Local stand-in for the exchange side: multicasts what it is given, with the
+// Write* calls of MarketDataWriter, and answers snapshot requests from its own
+// thread whenever it flushes. Not meant for hot paths.
+class FeedPublisher
+{
+public:
+    FeedPublisher();
+    ~FeedPublisher();
+
+    FeedPublisher(const FeedPublisher&) = delete;
+    FeedPublisher& operator=(const FeedPublisher&) = delete;
+
+    bool Open(const std::string& group, uint16_t port, uint16_t snapshot_port);
+    void Close();
+    bool IsOpen() const { return udp_fd != -1; }
+
+    void WriteCandle(const Candle& candle);
+    void WriteTrade(const Trade& trade);
+    void WriteBook(double time, bool is_bid, Price price, Qty volume);
+
+    // Sends the pending packet and serves waiting snapshot requests.
+    void Flush();
+    // Flushes and tells receivers the session is over.
+    void Finish();
+
+    // Test hook: every Nth packet is not sent (its sequence numbers are still used).
+    int drop_every = 0;
+
+    uint64_t LastSeq() const { return next_seq - 1; }
+    uint64_t PacketsSent() const { return packets_sent; }
+    uint64_t PacketsDropped() const { return packets_dropped; }
+    uint64_t SnapshotsServed() const { return snapshots_served; }
+
+private:
+    int udp_fd = -1;
+    int listen_fd = -1;
+    uint32_t group_addr = 0;
+    uint16_t group_port = 0;
+
+    unsigned char packet[FEED_MAX_PACKET];
+    size_t pending = 0;
+    uint64_t next_seq = 1;
+    uint64_t candles_published = 0;
+    uint64_t packets_sent = 0;
+    uint64_t packets_dropped = 0;
+    uint64_t snapshots_served = 0;
+
+    // State as of LastSeq(), for snapshots.
+    std::map<Price, Qty> bids;
+    std::map<Price, Qty> asks;
+    RingBuffer<Candle> recent_candles;
+    std::vector<MarketRecord> snapshot;
+
+    void Append(const MarketRecord& record);
+    void SendPacket(uint16_t flags);
+    void ServeSnapshots();
+};
+
+// Receives the feed as a MarketDataSource. Advance waits up to
+// poll_timeout_ms for packets, reads up to BATCH of them with one recvmmsg
+// and applies their records in sequence. A gap starts a snapshot request
+// that never blocks: Advance carries the TCP exchange forward while holding
+// live packets (up to HOLD_PACKETS, oldest dropped first), then applies the
+// snapshot and the held packets after it. A recovery that takes longer than
+// a second fails, and the feed carries on from the held packets.
+// Receive, hold and snapshot buffers are allocated by Open, so the socket
+// side allocates nothing per message; applying a record can still allocate
+// inside the engine's order book when it opens a new price level.
+class FeedHandler : public MarketDataSource
+{
+public:
+    static constexpr int BATCH = 64;
+    static constexpr size_t HOLD_PACKETS = 1024;
+
+    FeedHandler();
+    ~FeedHandler() override;
+
+    FeedHandler(const FeedHandler&) = delete;
+    FeedHandler& operator=(const FeedHandler&) = delete;
+
+    bool Open(const std::string& group, uint16_t port, uint16_t snapshot_port);
+    void Close();
+
+    // Returns false once the publisher has ended the session.
+    bool Advance(TradingEngine& engine) override;
+
+    int poll_timeout_ms = 100;
+    const FeedStats& Stats() const { return stats; }
+    uint64_t LastSeq() const { return expected_seq - 1; }
+
+private:
+    enum RecoveryState
+    {
+        RECOVERY_NONE,
+        RECOVERY_CONNECTING,
+        RECOVERY_RECEIVING
+    };
+
+    struct Batch;
+
+    int fd = -1;
+    uint16_t snapshot_port = 0;
+    std::unique_ptr<Batch> batch;
+    std::vector<MarketRecord> snapshot;
+
+    uint64_t expected_seq = 1;
+    // After a failed recovery the next packet is taken as it comes.
+    bool resync = false;
+    uint64_t candles_applied = 0;
+    bool ended = false;
+    FeedStats stats;
+
+    RecoveryState recovery = RECOVERY_NONE;
+    int snapshot_fd = -1;
+    FeedSnapshotHeader snapshot_header = {};
+    size_t snapshot_received = 0;
+    std::chrono::steady_clock::time_point recovery_deadline;
+    size_t held_first = 0;
+    size_t held_count = 0;
+
+    // Returns false, leaving the packet unconsumed, if it revealed a gap and started a recovery.
+    bool ProcessPacket(TradingEngine& engine, const unsigned char* data, size_t size);
+    void Apply(TradingEngine& engine, const MarketRecord& record);
+    void Hold(const unsigned char* data, size_t size);
+    void DrainHeld(TradingEngine& engine);
+
+    void StartRecovery();
+    void ContinueRecovery(TradingEngine& engine, short events);
+    void FinishRecovery(TradingEngine& engine, bool received);
+    void ApplySnapshot(TradingEngine& engine);
+};
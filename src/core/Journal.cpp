@@ -0,0 +1,264 @@
+#include "Journal.h"
+#include "TradingEngine.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char JOURNAL_MAGIC[8] = {'T', 'R', 'D', 'J', 'R', 'N', 'L', '1'};
+    constexpr size_t HEADER_SIZE = 64;
+    constexpr size_t RECORD_SIZE = sizeof(JournalRecord);
+    constexpr size_t INITIAL_SIZE = HEADER_SIZE + RECORD_SIZE * 65536;
+
+    double BitsDouble(int64_t bits)
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    size_t PageFloor(size_t offset)
+    {
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        return offset - offset % page;
+    }
+}
+
+JournalWriter::JournalWriter() {}
+
+JournalWriter::~JournalWriter()
+{
+    Close();
+}
+
+bool JournalWriter::Open(const std::string& path, bool truncate)
+{
+    Close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    bool fresh = (size_t)st.st_size < HEADER_SIZE;
+    size_t size = std::max((size_t)st.st_size, INITIAL_SIZE);
+    if ((size != (size_t)st.st_size && ftruncate(fd, (off_t)size) != 0) || !Map(size))
+    {
+        Close();
+        return false;
+    }
+
+    if (fresh)
+    {
+        std::memcpy(mapping, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        uint32_t record_size = RECORD_SIZE;
+        std::memcpy(mapping + 8, &record_size, sizeof(record_size));
+    } else if (std::memcmp(mapping, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    uint64_t capacity = (mapped_size - HEADER_SIZE) / RECORD_SIZE;
+    count = 0;
+    while (count < capacity && mapping[HEADER_SIZE + count * RECORD_SIZE] != EVT_NONE) ++count;
+    flushed = count;
+    return true;
+}
+
+void JournalWriter::Close()
+{
+    if (mapping)
+    {
+        Flush(true);
+        munmap(mapping, mapped_size);
+        mapping = nullptr;
+    }
+    if (fd != -1)
+    {
+        int rc = ftruncate(fd, (off_t)(HEADER_SIZE + count * RECORD_SIZE));
+        (void)rc;
+        ::close(fd);
+        fd = -1;
+    }
+    mapped_size = 0;
+    count = 0;
+    flushed = 0;
+}
+
+void JournalWriter::Append(const JournalRecord& record)
+{
+    if (!mapping) return;
+    if (HEADER_SIZE + (count + 1) * RECORD_SIZE > mapped_size && !Grow()) return;
+
+    std::memcpy(mapping + HEADER_SIZE + count * RECORD_SIZE, &record, RECORD_SIZE);
+    ++count;
+
+    if (count - flushed >= flush_interval) Flush();
+}
+
+void JournalWriter::Append(uint8_t type, uint8_t flags, int64_t a, int64_t b, int32_t order_id, uint8_t order_type)
+{
+    JournalRecord record = {type, flags, order_type, 0, order_id, a, b, 0};
+    Append(record);
+}
+
+void JournalWriter::Flush(bool wait)
+{
+    if (!mapping || count == flushed) return;
+
+    size_t begin = PageFloor(HEADER_SIZE + flushed * RECORD_SIZE);
+    size_t end = HEADER_SIZE + count * RECORD_SIZE;
+    msync(mapping + begin, end - begin, wait ? MS_SYNC : MS_ASYNC);
+    flushed = count;
+}
+
+bool JournalWriter::Map(size_t size)
+{
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+
+    mapping = (unsigned char*)p;
+    mapped_size = size;
+    return true;
+}
+
+bool JournalWriter::Grow()
+{
+    Flush();
+    size_t new_size = mapped_size * 2;
+    munmap(mapping, mapped_size);
+    mapping = nullptr;
+
+    if (ftruncate(fd, (off_t)new_size) != 0 || !Map(new_size))
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+JournalReader::JournalReader() {}
+
+JournalReader::~JournalReader()
+{
+    Close();
+}
+
+bool JournalReader::Open(const std::string& path)
+{
+    Close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE)
+    {
+        Close();
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    mapping = (const unsigned char*)p;
+    mapped_size = (size_t)st.st_size;
+    madvise((void*)mapping, mapped_size, MADV_SEQUENTIAL);
+
+    if (std::memcmp(mapping, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    capacity = (mapped_size - HEADER_SIZE) / RECORD_SIZE;
+    position = 0;
+    return true;
+}
+
+void JournalReader::Close()
+{
+    if (mapping) munmap((void*)mapping, mapped_size);
+    if (fd != -1) ::close(fd);
+    mapping = nullptr;
+    fd = -1;
+    mapped_size = 0;
+    capacity = 0;
+    position = 0;
+}
+
+bool JournalReader::Next(JournalRecord& record)
+{
+    if (position >= capacity) return false;
+
+    const unsigned char* p = mapping + HEADER_SIZE + position * RECORD_SIZE;
+    if (p[0] == EVT_NONE) return false;
+
+    std::memcpy(&record, p, RECORD_SIZE);
+    ++position;
+    return true;
+}
+
+bool ReplayJournal(const std::string& path, TradingEngine& engine, ReplayStats& stats)
+{
+    JournalReader reader;
+    if (!reader.Open(path)) return false;
+
+    JournalRecord r;
+    while (reader.Next(r))
+    {
+        bool is_buy = (r.flags & JF_BUY) != 0;
+        bool reduce_only = (r.flags & JF_REDUCE_ONLY) != 0;
+
+        switch (r.type)
+        {
+            case EVT_INIT: engine.Init((uint32_t)r.a, BitsDouble(r.b)); break;
+            case EVT_TICK:
+                engine.Step();
+                stats.ticks++;
+                if (engine.state.current_price != r.a || (int64_t)engine.state.candles.TotalPushed() != r.b)
+                {
+                    stats.diverged = true;
+                    return false;
+                }
+                break;
+            case EVT_PLACE_ORDER: engine.PlaceOrder(is_buy, r.order_type, r.a, r.b, reduce_only); break;
+            case EVT_CANCEL_ORDER: engine.CancelOrder(r.order_id); break;
+            case EVT_MODIFY_ORDER: engine.ModifyOrder(r.order_id, r.b); break;
+            case EVT_CANCEL_ALL: engine.CancelAllOrders(); break;
+            case EVT_CANCEL_RANGE: engine.CancelOrders(is_buy, r.a, r.b); break;
+            case EVT_SET_PAUSED: engine.SetPaused(r.a != 0); break;
+            case EVT_SET_INTERVAL: engine.SetSimulationInterval(BitsDouble(r.a)); break;
+            case EVT_SET_TICKS: engine.SetTicksPerCandle((int)r.a); break;
+            default: break;
+        }
+        stats.events++;
+    }
+    return true;
+}
+
+std::string SetAsideJournal(const std::string& path)
+{
+    for (int n = 1; n < 1000; ++n)
+    {
+        std::string candidate = path + ".diverged-" + std::to_string(n);
+        if (::access(candidate.c_str(), F_OK) == 0) continue;
+        return (std::rename(path.c_str(), candidate.c_str()) == 0) ? candidate : std::string();
+    }
+    return std::string();
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "Models.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TradingEngine;
+
+enum JournalEventType : uint8_t
+{
+    EVT_NONE = 0,
+    EVT_INIT = 1,
+    EVT_TICK = 2,
+    EVT_PLACE_ORDER = 3,
+    EVT_CANCEL_ORDER = 4,
+    EVT_MODIFY_ORDER = 5,
+    EVT_CANCEL_ALL = 6,
+    EVT_CANCEL_RANGE = 7,
+    EVT_FILL = 8,
+    EVT_SET_PAUSED = 9,
+    EVT_SET_INTERVAL = 10,
+    EVT_SET_TICKS = 11
+};
+
+enum JournalFlags : uint8_t
+{
+    JF_BUY = 1,
+    JF_REDUCE_ONLY = 2
+};
+
+// One fixed-size journal entry. Field meaning depends on type:
+//   INIT         a = seed, b = start time (double bits)
+//   TICK         a = close, b = candles pushed (checked on replay)
+//   PLACE_ORDER  a = price, b = amount, order_type
+//   CANCEL_ORDER order_id
+//   MODIFY_ORDER order_id, b = amount
+//   CANCEL_RANGE a = low, b = high
+//   FILL         a = notional, b = amount, order_type (audit only, derived on replay)
+//   SET_PAUSED   a = paused
+//   SET_INTERVAL a = interval (double bits)
+//   SET_TICKS    a = ticks per candle
+struct JournalRecord
+{
+    uint8_t type;
+    uint8_t flags;
+    uint8_t order_type;
+    uint8_t reserved;
+    int32_t order_id;
+    int64_t a;
+    int64_t b;
+    int64_t c;
+};
+
+static_assert(sizeof(JournalRecord) == 32, "journal records must stay 32 bytes");
+
+// Append-only journal on a memory-mapped file. Appends are a copy into the
+// mapping; dirty pages are handed to the kernel every flush_interval records
+// and synced on Close. The file grows by doubling. A crash leaves zeroed
+// records after the last append, which readers treat as the end.
+class JournalWriter
+{
+public:
+    JournalWriter();
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    // Opens (or creates) the journal and positions after its last record; truncate starts over.
+    bool Open(const std::string& path, bool truncate = false);
+    void Close();
+    bool IsOpen() const { return fd != -1; }
+
+    void Append(const JournalRecord& record);
+    void Append(uint8_t type, uint8_t flags, int64_t a, int64_t b, int32_t order_id = 0, uint8_t order_type = 0);
+    void Flush(bool wait = false);
+
+    uint64_t RecordCount() const { return count; }
+
+    uint64_t flush_interval = 4096;
+
+private:
+    int fd = -1;
+    unsigned char* mapping = nullptr;
+    size_t mapped_size = 0;
+    uint64_t count = 0;
+    uint64_t flushed = 0;
+
+    bool Map(size_t size);
+    bool Grow();
+};
+
+class JournalReader
+{
+public:
+    JournalReader();
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool Next(JournalRecord& record);
+    uint64_t Position() const { return position; }
+
+private:
+    int fd = -1;
+    const unsigned char* mapping = nullptr;
+    size_t mapped_size = 0;
+    uint64_t capacity = 0;
+    uint64_t position = 0;
+};
+
+struct ReplayStats
+{
+    uint64_t events = 0;
+    uint64_t ticks = 0;
+    bool diverged = false;
+};
+
+// Rebuilds engine state by re-applying every input event. The engine must not
+// have a journal attached. Returns false if the file cannot be read or a tick
+// no longer produces the recorded price (journal from a different build).
+bool ReplayJournal(const std::string& path, TradingEngine& engine, ReplayStats& stats);
+
+// Renames a journal that can no longer be replayed to path.diverged-N (the first free N),
+// so a new journal can start without destroying it. Returns the new path, or empty on failure.
+std::string SetAsideJournal(const std::string& path);
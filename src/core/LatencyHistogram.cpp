@@ -0,0 +1,64 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void FormatNanos(int64_t ns, char* buf, size_t size)
+{
+    if (ns < 1000) std::snprintf(buf, size, "%lld ns", (long long)ns);
+    else if (ns < 1000000) std::snprintf(buf, size, "%.1f us", ns / 1e3);
+    else if (ns < 1000000000) std::snprintf(buf, size, "%.2f ms", ns / 1e6);
+    else std::snprintf(buf, size, "%.2f s", ns / 1e9);
+}
+
+void LatencyHistogram::Reset()
+{
+    std::fill(buckets, buckets + BUCKET_COUNT, 0);
+    count = 0;
+    max = 0;
+}
+
+uint64_t LatencyHistogram::BucketHigh(size_t bucket)
+{
+    if (bucket < SUB_COUNT) return bucket;
+    size_t shift = bucket / SUB_COUNT - 1;
+    uint64_t sub = bucket % SUB_COUNT + SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+int64_t LatencyHistogram::Percentile(double q) const
+{
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(std::min(std::max(q, 0.0), 1.0) * count);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank) return (int64_t)std::min(BucketHigh(i), max);
+    }
+    return (int64_t)max;
+}
+
+void LatencyHistogram::Summarize(LatencySummary& out) const
+{
+    out.count = count;
+    out.max_ns = (int64_t)max;
+    out.p50_ns = out.p99_ns = out.p999_ns = 0;
+    if (count == 0) return;
+
+    // One pass for all three ranks; they are non-decreasing.
+    const double quantiles[3] = {0.50, 0.99, 0.999};
+    int64_t* targets[3] = {&out.p50_ns, &out.p99_ns, &out.p999_ns};
+    int next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && next < 3; ++i)
+    {
+        seen += buckets[i];
+        while (next < 3 && seen >= std::max<uint64_t>(1, (uint64_t)std::ceil(quantiles[next] * count)))
+        {
+            *targets[next++] = (int64_t)std::min(BucketHigh(i), max);
+        }
+    }
+}
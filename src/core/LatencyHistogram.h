@@ -0,0 +1,72 @@
+#pragma once
+#include "Models.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Monotonic nanoseconds for order latency stamps.
+inline int64_t MonotonicNanos()
+{
+    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes ns with a readable unit, e.g. "850 ns", "12.4 us", "3.10 ms", "1.50 s".
+void FormatNanos(int64_t ns, char* buf, size_t size);
+
+// HDR-style latency histogram in nanoseconds: every power-of-two range is
+// split into SUB_COUNT linear buckets, so a recorded value is off by at most
+// 1/SUB_COUNT (about 3%). Memory is fixed and Record is O(1). Values above
+// 2^(MAX_SHIFT + SUB_BITS + 1) ns (~73 min) share the last bucket; Max() stays exact.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr size_t SUB_COUNT = (size_t)1 << SUB_BITS;
+    static constexpr int MAX_SHIFT = 36;
+    static constexpr size_t BUCKET_COUNT = (MAX_SHIFT + 2) * SUB_COUNT;
+
+    void Record(int64_t ns)
+    {
+        uint64_t value = (ns > 0) ? (uint64_t)ns : 0;
+        buckets[BucketOf(value)]++;
+        count++;
+        if (value > max) max = value;
+    }
+
+    void Reset();
+
+    uint64_t Count() const { return count; }
+    int64_t Max() const { return (int64_t)max; }
+    // Upper edge of the bucket holding the sample of rank ceil(q * Count()), capped at Max().
+    int64_t Percentile(double q) const;
+    void Summarize(LatencySummary& out) const;
+
+private:
+    uint64_t buckets[BUCKET_COUNT] = {};
+    uint64_t count = 0;
+    uint64_t max = 0;
+
+    static int HighestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return (int)index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static size_t BucketOf(uint64_t value)
+    {
+        if (value < SUB_COUNT) return (size_t)value;
+        int shift = HighestBit(value) - SUB_BITS;
+        if (shift > MAX_SHIFT) return BUCKET_COUNT - 1;
+        return (size_t)(shift + 1) * SUB_COUNT + (size_t)((value >> shift) - SUB_COUNT);
+    }
+
+    static uint64_t BucketHigh(size_t bucket);
+};
@@ -0,0 +1,202 @@
+#include "MarketDataSource.h"
+#include "TradingEngine.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char MARKET_MAGIC[8] = {'T', 'R', 'D', 'M', 'K', 'T', 'D', '1'};
+    constexpr size_t HEADER_SIZE = 64;
+
+    struct MarketFileHeader
+    {
+        char magic[8];
+        uint32_t record_size;
+        uint32_t reserved;
+        double tick_size;
+        double lot_size;
+        char symbol[16];
+        char padding[16];
+    };
+
+    static_assert(sizeof(MarketFileHeader) == HEADER_SIZE, "market file header must stay 64 bytes");
+}
+
+void ApplyMarketRecord(TradingEngine& engine, const MarketRecord& record)
+{
+    switch (record.type)
+    {
+        case MD_CANDLE: engine.ApplyCandle({record.time, record.price, record.high, record.low, record.close, record.volume}); break;
+        case MD_TRADE: engine.ApplyTrade({record.time, record.price, record.volume, record.is_buy != 0}); break;
+        case MD_BOOK: engine.ApplyBookUpdate(record.is_buy != 0, record.price, record.volume); break;
+        default: break;
+    }
+}
+
+ReplaySource::ReplaySource() {}
+
+ReplaySource::~ReplaySource()
+{
+    Close();
+}
+
+bool ReplaySource::Open(const std::string& path, const Instrument& instrument)
+{
+    Close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_SIZE)
+    {
+        Close();
+        return false;
+    }
+
+    mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        Close();
+        return false;
+    }
+    mapped_size = (size_t)st.st_size;
+    madvise(mapping, mapped_size, MADV_SEQUENTIAL);
+
+    const MarketFileHeader* header = (const MarketFileHeader*)mapping;
+    if (std::memcmp(header->magic, MARKET_MAGIC, sizeof(MARKET_MAGIC)) != 0 || header->record_size != sizeof(MarketRecord) ||
+        header->tick_size != instrument.tick_size || header->lot_size != instrument.lot_size)
+    {
+        Close();
+        return false;
+    }
+
+    records = (const MarketRecord*)((const unsigned char*)mapping + HEADER_SIZE);
+    count = (mapped_size - HEADER_SIZE) / sizeof(MarketRecord);
+    cursor = 0;
+    started = false;
+    return true;
+}
+
+void ReplaySource::Close()
+{
+    if (mapping) munmap(mapping, mapped_size);
+    if (fd != -1) ::close(fd);
+    fd = -1;
+    mapping = nullptr;
+    mapped_size = 0;
+    records = nullptr;
+    count = 0;
+    cursor = 0;
+}
+
+bool ReplaySource::Advance(TradingEngine& engine)
+{
+    if (cursor >= count) return false;
+
+    if (speed <= 0.0)
+    {
+        while (cursor < count)
+        {
+            const MarketRecord& record = records[cursor++];
+            ApplyMarketRecord(engine, record);
+            if (record.type == MD_CANDLE) break;
+        }
+        return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!started)
+    {
+        started = true;
+        wall_start = now;
+        data_start = records[cursor].time;
+    }
+
+    double horizon = data_start + std::chrono::duration<double>(now - wall_start).count() * speed;
+    while (cursor < count && records[cursor].time <= horizon)
+    {
+        ApplyMarketRecord(engine, records[cursor++]);
+    }
+    return true;
+}
+
+MarketDataWriter::MarketDataWriter() {}
+
+MarketDataWriter::~MarketDataWriter()
+{
+    Close();
+}
+
+bool MarketDataWriter::Open(const std::string& path, const Instrument& instrument)
+{
+    Close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    MarketFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MARKET_MAGIC, sizeof(MARKET_MAGIC));
+    header.record_size = sizeof(MarketRecord);
+    header.tick_size = instrument.tick_size;
+    header.lot_size = instrument.lot_size;
+    std::memcpy(header.symbol, instrument.symbol, sizeof(header.symbol));
+
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MarketDataWriter::Close()
+{
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+void MarketDataWriter::WriteCandle(const Candle& candle)
+{
+    MarketRecord r = {};
+    r.time = candle.time;
+    r.type = MD_CANDLE;
+    r.price = candle.open;
+    r.high = candle.high;
+    r.low = candle.low;
+    r.close = candle.close;
+    r.volume = candle.volume;
+    Write(r);
+}
+
+void MarketDataWriter::WriteTrade(const Trade& trade)
+{
+    MarketRecord r = {};
+    r.time = trade.time;
+    r.type = MD_TRADE;
+    r.is_buy = trade.is_buy ? 1 : 0;
+    r.price = trade.price;
+    r.volume = trade.amount;
+    Write(r);
+}
+
+void MarketDataWriter::WriteBook(double time, bool is_bid, Price price, Qty volume)
+{
+    MarketRecord r = {};
+    r.time = time;
+    r.type = MD_BOOK;
+    r.is_buy = is_bid ? 1 : 0;
+    r.price = price;
+    r.volume = volume;
+    Write(r);
+}
+
+void MarketDataWriter::Write(const MarketRecord& record)
+{
+    if (file) std::fwrite(&record, sizeof(record), 1, file);
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include "Models.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class TradingEngine;
+
+// Drives the market side of TradingEngine::Step(). Advance feeds the next
+// slice of market data through the engine's Apply* calls and returns false
+// once the source is exhausted. Without a source the engine runs its
+// built-in random walk (GenerateMarketData).
+class MarketDataSource
+{
+public:
+    virtual ~MarketDataSource() {}
+    virtual bool Advance(TradingEngine& engine) = 0;
+};
+
+enum MarketRecordType : uint8_t
+{
+    MD_CANDLE = 1,
+    MD_TRADE = 2,
+    MD_BOOK = 3
+};
+
+// Fixed-size record of a market data file, read in place from the mapping.
+//   CANDLE  price/high/low/close = OHLC, volume
+//   TRADE   price, volume = amount, is_buy = aggressor side
+//   BOOK    price, volume = resting volume at that level (0 removes it), is_buy = bid side
+// Trades and book updates for a minute precede that minute's candle.
+struct MarketRecord
+{
+    double time;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[6];
+    Price price;
+    Price high;
+    Price low;
+    Price close;
+    Qty volume;
+};
+
+static_assert(sizeof(MarketRecord) == 56, "market records must stay 56 bytes");
+
+// Feeds one record through the matching TradingEngine::Apply* call.
+void ApplyMarketRecord(TradingEngine& engine, const MarketRecord& record);
+
+enum OrderAction : uint8_t
+{
+    ORDER_ACTION_NEW = 1,
+    ORDER_ACTION_CANCEL = 2,
+    ORDER_ACTION_MODIFY = 3
+};
+
+// User order sent to an external matching engine. Cancel and modify refer to
+// order_id; modify sets the open amount.
+struct OrderRequest
+{
+    int64_t submit_ns;
+    int32_t order_id;
+    uint8_t action;
+    uint8_t order_type;
+    uint8_t is_buy;
+    uint8_t reduce_only;
+    Price price;
+    Qty amount;
+};
+
+enum ExecutionStatus : uint8_t
+{
+    EXEC_NEW = 1,
+    EXEC_FILL = 2,
+    EXEC_REPLACED = 3,
+    EXEC_CANCELED = 4,
+    EXEC_REJECTED = 5
+};
+
+// An external engine's answer to an OrderRequest. FILL carries the fill price and
+// amount; every status carries the order's open amount afterwards (0 once it is done).
+struct ExecutionReport
+{
+    double time;
+    int32_t order_id;
+    uint8_t status;
+    uint8_t reserved[3];
+    Price price;
+    Qty amount;
+    Qty leaves;
+};
+
+// Where TradingEngine sends user orders when an external engine matches them.
+// Send returns false if the request could not be queued.
+class OrderGateway
+{
+public:
+    virtual ~OrderGateway() {}
+    virtual bool Send(const OrderRequest& request) = 0;
+};
+
+// Streams a recorded market data file from a read-only mapping. One Advance
+// applies records up to and including the next candle when unthrottled
+// (speed 0), or every record whose time the paced clock has reached when
+// speed is N (1 = real time).
+class ReplaySource : public MarketDataSource
+{
+public:
+    ReplaySource();
+    ~ReplaySource() override;
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // Fails if the file is not a market data file for the given instrument.
+    bool Open(const std::string& path, const Instrument& instrument);
+    void Close();
+
+    bool Advance(TradingEngine& engine) override;
+
+    size_t RecordCount() const { return count; }
+    size_t Position() const { return cursor; }
+
+    double speed = 0.0;
+
+private:
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mapped_size = 0;
+    const MarketRecord* records = nullptr;
+    size_t count = 0;
+    size_t cursor = 0;
+
+    bool started = false;
+    double data_start = 0.0;
+    std::chrono::steady_clock::time_point wall_start;
+
+};
+
+// Writes market data files for ReplaySource. Buffered, not meant for hot paths.
+class MarketDataWriter
+{
+public:
+    MarketDataWriter();
+    ~MarketDataWriter();
+
+    MarketDataWriter(const MarketDataWriter&) = delete;
+    MarketDataWriter& operator=(const MarketDataWriter&) = delete;
+
+    bool Open(const std::string& path, const Instrument& instrument);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+
+    void WriteCandle(const Candle& candle);
+    void WriteTrade(const Trade& trade);
+    void WriteBook(double time, bool is_bid, Price price, Qty volume);
+
+private:
+    FILE* file = nullptr;
+
+    void Write(const MarketRecord& record);
+};
@@ -1,96 +1,416 @@
 #pragma once
+#include "RingBuffer.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
-#include <random>
 
+// Prices are integer ticks and quantities integer lots of the instrument.
+// Notional values (price * quantity, PnL, balances) are ticks * lots.
+using Price = int64_t;
+using Qty = int64_t;
+using Notional = int64_t;
+
+struct Instrument
+{
+    char symbol[16] = "BTC/USD";
+    double tick_size = 0.01;
+    double lot_size = 0.0001;
+
+    Price ToTicks(double price) const { return (Price)std::llround(price / tick_size); }
+    Qty ToLots(double amount) const { return (Qty)std::llround(amount / lot_size); }
+    Notional ToNotional(double value) const { return (Notional)std::llround(value / (tick_size * lot_size)); }
+
+    double ToPrice(double ticks) const { return ticks * tick_size; }
+    double ToAmount(Qty lots) const { return lots * lot_size; }
+    double ToValue(Notional notional) const { return notional * tick_size * lot_size; }
+};
+
+// a * b / c for non-negative operands without overflowing the intermediate product
+inline int64_t MulDiv(int64_t a, int64_t b, int64_t c)
+{
+    return (a / c) * b + (a % c) * b / c;
+}
+
+constexpr int TIMEFRAME_COUNT = 6;
+constexpr int TIMEFRAME_MINUTES[TIMEFRAME_COUNT] = {1, 5, 15, 60, 240, 1440};
+
+constexpr size_t DEFAULT_CANDLE_CAPACITY = 200000;
+constexpr size_t DEFAULT_EQUITY_CAPACITY = 500000;
+constexpr size_t DEFAULT_TAPE_CAPACITY = 5000;
+
+// Random walk behind the synthetic market, in quote currency per 1m candle:
+// close = open + N(0, step_sigma), each wick reaches U(0, wick_max) beyond
+// the body and volume is U(volume_min, volume_max) in base units. In tick
+// mode (TradingState::ticks_per_candle > 0) the minute is a path of n trades
+// with steps N(0, step_sigma / sqrt(n)) and sizes U(volume_min, volume_max) / n,
+// so closes and volumes keep the same distribution and wicks are the path's extremes.
+struct MarketModel
+{
+    double step_sigma = 30.0;
+    double wick_max = 10.0;
+    double volume_min = 0.5;
+    double volume_max = 10.0;
+};
 
 struct Candle
 {
     double time;
-    double open;
-    double high;
-    double low;
-    double close;
-    double volume;
+    Price open;
+    Price high;
+    Price low;
+    Price close;
+    Qty volume;
+};
+
+// Candle history as a ring buffer stored column by column: each field has
+// its own array and a candle occupies the same slot in all of them, so the
+// renderer reads times and prices straight from the columns without
+// transposing. Same rules as RingBuffer: fixed capacity, only the newest
+// candle may change, and copies within a lineage only copy what was appended.
+class CandleSeries
+{
+public:
+    CandleSeries() : CandleSeries(0) {}
+    explicit CandleSeries(size_t capacity) : capacity(capacity), generation(NextRingGeneration()) {}
+
+    CandleSeries(const CandleSeries&) = default;
+    CandleSeries(CandleSeries&&) = default;
+    CandleSeries& operator=(CandleSeries&&) = default;
+
+    CandleSeries& operator=(const CandleSeries& other)
+    {
+        if (this == &other) return *this;
+
+        if (generation != other.generation || capacity != other.capacity || pushed > other.pushed)
+        {
+            times = other.times;
+            opens = other.opens;
+            highs = other.highs;
+            lows = other.lows;
+            closes = other.closes;
+            volumes = other.volumes;
+            capacity = other.capacity;
+            generation = other.generation;
+            pushed = other.pushed;
+            return *this;
+        }
+
+        size_t size = other.Size();
+        if (times.size() < size)
+        {
+            times.resize(size);
+            opens.resize(size);
+            highs.resize(size);
+            lows.resize(size);
+            closes.resize(size);
+            volumes.resize(size);
+        }
+
+        uint64_t oldest = other.pushed - size;
+        uint64_t first = (pushed > 0) ? pushed - 1 : 0;
+        if (first < oldest) first = oldest;
+
+        for (uint64_t seq = first; seq < other.pushed; ++seq)
+        {
+            size_t slot = (size_t)(seq % capacity);
+            times[slot] = other.times[slot];
+            opens[slot] = other.opens[slot];
+            highs[slot] = other.highs[slot];
+            lows[slot] = other.lows[slot];
+            closes[slot] = other.closes[slot];
+            volumes[slot] = other.volumes[slot];
+        }
+        pushed = other.pushed;
+        return *this;
+    }
+
+    void SetCapacity(size_t new_capacity)
+    {
+        capacity = new_capacity;
+        Clear();
+    }
+
+    void Clear()
+    {
+        times.clear();
+        opens.clear();
+        highs.clear();
+        lows.clear();
+        closes.clear();
+        volumes.clear();
+        pushed = 0;
+        generation = NextRingGeneration();
+    }
+
+    void PushBack(const Candle& c)
+    {
+        if (capacity == 0) return;
+        if (times.size() < capacity)
+        {
+            times.push_back(c.time);
+            opens.push_back(c.open);
+            highs.push_back(c.high);
+            lows.push_back(c.low);
+            closes.push_back(c.close);
+            volumes.push_back(c.volume);
+        } else
+        {
+            Store((size_t)(pushed % capacity), c);
+        }
+        ++pushed;
+    }
+
+    // Replaces the newest candle.
+    void UpdateBack(const Candle& c) { Store(BackSlot(), c); }
+
+    size_t Size() const { return times.size(); }
+    size_t Capacity() const { return capacity; }
+    bool Empty() const { return times.empty(); }
+    uint64_t TotalPushed() const { return pushed; }
+    uint64_t Generation() const { return generation; }
+
+    // Slot of the oldest candle; candle i lives in Slot(i).
+    size_t Offset() const { return (times.size() < capacity) ? 0 : (size_t)(pushed % capacity); }
+    size_t Slot(size_t i) const
+    {
+        size_t slot = Offset() + i;
+        return (slot < times.size()) ? slot : slot - times.size();
+    }
+    size_t BackSlot() const { return (size_t)((pushed - 1) % capacity); }
+
+    Candle operator[](size_t i) const { return At(Slot(i)); }
+    Candle Front() const { return At(Offset()); }
+    Candle Back() const { return At(BackSlot()); }
+
+    // Raw columns indexed by slot, matching ImPlot's offset convention.
+    const double* Times() const { return times.data(); }
+    const Price* Opens() const { return opens.data(); }
+    const Price* Highs() const { return highs.data(); }
+    const Price* Lows() const { return lows.data(); }
+    const Price* Closes() const { return closes.data(); }
+    const Qty* Volumes() const { return volumes.data(); }
+
+private:
+    std::vector<double> times;
+    std::vector<Price> opens;
+    std::vector<Price> highs;
+    std::vector<Price> lows;
+    std::vector<Price> closes;
+    std::vector<Qty> volumes;
+    size_t capacity = 0;
+    uint64_t generation = 0;
+    uint64_t pushed = 0;
+
+    Candle At(size_t slot) const { return {times[slot], opens[slot], highs[slot], lows[slot], closes[slot], volumes[slot]}; }
+
+    void Store(size_t slot, const Candle& c)
+    {
+        times[slot] = c.time;
+        opens[slot] = c.open;
+        highs[slot] = c.high;
+        lows[slot] = c.low;
+        closes[slot] = c.close;
+        volumes[slot] = c.volume;
+    }
 };
 
 struct OrderBookEntry
 {
-    double price;
-    double volume;
+    Price price;
+    Qty volume;
     bool is_bid;
 };
 
 struct Trade
 {
     double time;
-    double price;
-    double amount;
+    Price price;
+    Qty amount;
     bool is_buy;
 };
 
 struct PositionInfo
 {
-    double amount = 0.0;
-    double entry_price = 0.0;
-    double unrealized_pnl = 0.0;
+    Qty amount = 0;
+    Notional entry_cost = 0;
+    Notional unrealized_pnl = 0;
+
+    // Average entry price in (fractional) ticks.
+    double EntryTicks() const { return amount != 0 ? (double)entry_cost / std::abs(amount) : 0.0; }
 };
 
 enum OrderType
 {
     ORDER_LIMIT = 0,
     ORDER_MARKET = 1,
-    ORDER_FOK = 2
+    ORDER_FOK = 2,
+    ORDER_TYPE_COUNT = 3
 };
 
 struct MyOrder
 {
     int id;
     bool is_buy;
-    double price;
-    double amount;
+    Price price;
+    Qty amount;
     int order_type;
     double time;
     bool reduce_only = false;
+    // Monotonic ns when the order was submitted, for order-to-fill latency.
+    int64_t submit_ns = 0;
+};
+
+// Percentiles of one LatencyHistogram, in nanoseconds.
+struct LatencySummary
+{
+    uint64_t count = 0;
+    int64_t p50_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t p999_ns = 0;
+    int64_t max_ns = 0;
+};
+
+// Risk and return figures kept current by PerformanceTracker. Ratios and
+// volatilities are annualized from 1m equity returns; percentages are in %,
+// trade figures in quote currency.
+struct PerformanceSummary
+{
+    uint64_t samples = 0;
+    double annual_return = 0.0;
+    double sharpe = 0.0;
+    double sortino = 0.0;
+    double calmar = 0.0;
+    double volatility = 0.0;
+    double volatility_1h = 0.0;
+    double volatility_1d = 0.0;
+    double avg_win = 0.0;
+    double avg_loss = 0.0;
+    double expectancy = 0.0;
 };
 
 struct TradingState
 {
-    std::vector<Candle> candles;
+    TradingState();
+
+    CandleSeries candles;
+    // Higher timeframes, updated as each 1m candle arrives. Index 0 is unused: the 1m series is `candles`.
+    CandleSeries aggregated_candles[TIMEFRAME_COUNT];
     std::vector<OrderBookEntry> bids;
     std::vector<OrderBookEntry> asks;
-    std::vector<Trade> trade_history;
+    RingBuffer<Trade> trade_history;
 
-    double current_price = 42000.0;
+    Instrument instrument;
+
+    Price current_price = 0;
     double last_update_time = 0.0;
-    std::mt19937 rng;
 
-    double balance = 50000.0;
-    double equity = 50000.0;
+    Notional balance = 0;
+    Notional equity = 0;
     
-    std::vector<double> equity_history;
-    double max_equity = 50000.0;
+    // Equity in quote currency, kept as double because it is only ever plotted.
+    RingBuffer<double> equity_history;
+    Notional max_equity = 0;
     double max_drawdown = 0.0;
     int total_trades_count = 0;
+    // Closes that realized a profit or a loss; breakeven closes count in neither.
     int winning_trades = 0;
-    double gross_profit = 0.0;
-    double gross_loss = 0.0;
+    int losing_trades = 0;
+    Notional gross_profit = 0;
+    Notional gross_loss = 0;
+    PerformanceSummary performance;
 
     PositionInfo long_pos;
     PositionInfo short_pos;
     
+    // Unordered: removing an order moves the last one into its place.
     std::vector<MyOrder> open_orders;
-    std::vector<MyOrder> order_history;
+    RingBuffer<MyOrder> order_history;
     int order_id_counter = 1;
+    // FOK orders killed because the book could not fill them in full.
+    int killed_orders = 0;
+
+    // Per OrderType: submit to accept, and submit to each fill (resting limit orders included).
+    LatencySummary accept_latency[ORDER_TYPE_COUNT];
+    LatencySummary fill_latency[ORDER_TYPE_COUNT];
+
+    double simulation_update_interval_s = 1.0;
+    bool is_paused = false;
+    // Trades simulated per 1m candle; 0 generates whole candles.
+    int ticks_per_candle = 0;
+
+    // Set by EngineThread on every published snapshot; equal versions mean equal state.
+    uint64_t version = 0;
+};
+
+inline TradingState::TradingState()
+    : candles(DEFAULT_CANDLE_CAPACITY),
+      trade_history(DEFAULT_TAPE_CAPACITY),
+      equity_history(DEFAULT_EQUITY_CAPACITY),
+      order_history(DEFAULT_TAPE_CAPACITY)
+{
+    for (auto& series : aggregated_candles) series.SetCapacity(DEFAULT_CANDLE_CAPACITY);
+
+    current_price = instrument.ToTicks(42000.0);
+    balance = instrument.ToNotional(50000.0);
+    equity = balance;
+    max_equity = balance;
+}
+
+// Per-symbol account figures in quote currency, published by each shard for aggregation.
+struct AccountSummary
+{
+    double balance = 0.0;
+    double equity = 0.0;
+    double unrealized_pnl = 0.0;
+    double realized_pnl = 0.0;
+    int open_orders = 0;
+    int total_trades = 0;
+    int winning_trades = 0;
+};
+
+struct UIState
+{
+    int symbol_id = 0;
+    int timeframe_idx = 1;
 
-    char symbol[16] = "BTC/USD";
-    int timeframe_idx = 1; 
-    
     int order_type = 0;
     bool is_reduce_mode = false;
     float order_amount = 0.1f;
     float order_price = 42000.0f;
 
-    double simulation_update_interval_s = 1.0;
     int simulation_interval_idx = 2;
-    bool is_paused = false;
+    int ticks_per_candle_idx = 0;
+};
+
+enum CommandType
+{
+    CMD_PLACE_ORDER = 0,
+    CMD_CANCEL_ORDER = 1,
+    CMD_CLOSE_POSITION = 2,
+    CMD_SET_PAUSED = 3,
+    CMD_SET_INTERVAL = 4,
+    CMD_MODIFY_ORDER = 5,
+    CMD_CANCEL_ALL = 6,
+    CMD_CANCEL_RANGE = 7,
+    CMD_SET_TICKS = 8
+};
+
+struct EngineCommand
+{
+    int type = CMD_PLACE_ORDER;
+    bool is_buy = false;
+    int order_type = ORDER_LIMIT;
+    Price price = 0;
+    Price price_high = 0;
+    Qty amount = 0;
+    bool reduce_only = false;
+    int order_id = 0;
+    bool close_long = false;
+    bool close_short = false;
+    bool paused = false;
+    double interval_s = 0.0;
+    int ticks_per_candle = 0;
+    int64_t submit_ns = 0;
 };
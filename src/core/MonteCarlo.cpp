@@ -0,0 +1,229 @@
+#include "MonteCarlo.h"
+#include "TradingEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    uint64_t SplitMix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double Percentile(std::vector<double>& values, double q)
+    {
+        if (values.empty()) return 0.0;
+        size_t k = (size_t)(q * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+    void MeanStddev(const std::vector<double>& values, double& mean, double& stddev)
+    {
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        mean = values.empty() ? 0.0 : sum / values.size();
+
+        double sq = 0.0;
+        for (double v : values) sq += (v - mean) * (v - mean);
+        stddev = (values.size() > 1) ? std::sqrt(sq / (values.size() - 1)) : 0.0;
+    }
+}
+
+void RandomLanes::Seed(uint64_t seed, uint64_t first_stream)
+{
+    for (int l = 0; l < PATH_LANES; ++l)
+    {
+        uint64_t state = seed ^ ((first_stream + l + 1) * 0xD1B54A32D192ED03ull);
+        s0[l] = SplitMix64(state);
+        s1[l] = SplitMix64(state);
+        s2[l] = SplitMix64(state);
+        s3[l] = SplitMix64(state);
+    }
+}
+
+void RandomLanes::NextUniform(double* out)
+{
+    // Plain loops over fixed-size lane arrays: the compiler turns each into vector code.
+    for (int l = 0; l < PATH_LANES; ++l)
+    {
+        uint64_t result = s0[l] + s3[l];
+        uint64_t t = s1[l] << 17;
+        s2[l] ^= s0[l];
+        s3[l] ^= s1[l];
+        s1[l] ^= s2[l];
+        s0[l] ^= s3[l];
+        s2[l] ^= t;
+        s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+
+        // Top 52 bits as the mantissa of a double in [1, 2), avoiding a scalar int-to-double conversion.
+        uint64_t bits = (result >> 12) | 0x3FF0000000000000ull;
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        out[l] = d - 1.0;
+    }
+}
+
+PathGenerator::PathGenerator(const MarketModel& model, const Instrument& instrument, uint64_t seed)
+    : model(model), instrument(instrument), seed(seed)
+{
+}
+
+void PathGenerator::Generate(uint64_t first_path, int count, int minutes, Price start_price, double start_time, std::vector<Candle>& out)
+{
+    out.resize((size_t)count * minutes);
+    const double two_pi = 6.283185307179586;
+    const double volume_range = model.volume_max - model.volume_min;
+
+    double u1[PATH_LANES], u2[PATH_LANES], z0[PATH_LANES], z1[PATH_LANES];
+    double wick_up[PATH_LANES], wick_down[PATH_LANES], volume[PATH_LANES];
+    Price price[PATH_LANES];
+
+    for (int batch = 0; batch < count; batch += PATH_LANES)
+    {
+        int lanes_used = std::min(PATH_LANES, count - batch);
+        lanes.Seed(seed, first_path + batch);
+        for (int l = 0; l < PATH_LANES; ++l) price[l] = start_price;
+
+        for (int i = 0; i < minutes; ++i)
+        {
+            // Box-Muller yields two normals per pair of uniforms: one for this minute, one for the next.
+            if ((i & 1) == 0)
+            {
+                lanes.NextUniform(u1);
+                lanes.NextUniform(u2);
+                for (int l = 0; l < PATH_LANES; ++l)
+                {
+                    double r = std::sqrt(-2.0 * std::log(1.0 - u1[l])) * model.step_sigma;
+                    z0[l] = r * std::cos(two_pi * u2[l]);
+                    z1[l] = r * std::sin(two_pi * u2[l]);
+                }
+            }
+            const double* step = (i & 1) ? z1 : z0;
+
+            lanes.NextUniform(wick_up);
+            lanes.NextUniform(wick_down);
+            lanes.NextUniform(volume);
+
+            double t = start_time + i * 60.0;
+            for (int l = 0; l < lanes_used; ++l)
+            {
+                Price open = price[l];
+                Price close = open + instrument.ToTicks(step[l]);
+                Candle& c = out[(size_t)(batch + l) * minutes + i];
+                c.time = t;
+                c.open = open;
+                c.close = close;
+                c.high = std::max(open, close) + instrument.ToTicks(wick_up[l] * model.wick_max);
+                c.low = std::min(open, close) - instrument.ToTicks(wick_down[l] * model.wick_max);
+                c.volume = instrument.ToLots(model.volume_min + volume[l] * volume_range);
+                price[l] = close;
+            }
+        }
+    }
+}
+
+PathSource::PathSource(const Candle* candles, size_t count) : candles(candles), count(count) {}
+
+bool PathSource::Advance(TradingEngine& engine)
+{
+    if (cursor >= count) return false;
+    engine.ApplyCandle(candles[cursor++]);
+    // Paths are candles only, so market orders need synthetic depth to fill against.
+    engine.QuoteSyntheticBook();
+    return true;
+}
+
+MonteCarloSummary RunMonteCarlo(const MonteCarloConfig& config, const PathStrategy& strategy)
+{
+    MonteCarloSummary summary;
+    if (config.paths == 0 || config.minutes <= 0) return summary;
+
+    int thread_count = (config.threads > 0) ? config.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    uint64_t batches = (config.paths + PATH_LANES - 1) / PATH_LANES;
+    thread_count = (int)std::min<uint64_t>(thread_count, batches);
+
+    std::vector<PathResult> results(config.paths);
+    std::atomic<uint64_t> next_batch{0};
+    Price start_price = config.instrument.ToTicks(config.start_price);
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]()
+    {
+        PathGenerator generator(config.model, config.instrument, config.seed);
+        std::vector<Candle> candles;
+
+        for (uint64_t batch = next_batch++; batch < batches; batch = next_batch++)
+        {
+            uint64_t first = batch * PATH_LANES;
+            int count = (int)std::min<uint64_t>(PATH_LANES, config.paths - first);
+            generator.Generate(first, count, config.minutes, start_price, config.start_time, candles);
+
+            for (int p = 0; p < count; ++p)
+            {
+                const Candle* path = candles.data() + (size_t)p * config.minutes;
+                PathResult& result = results[first + p];
+
+                double open = config.instrument.ToPrice(path[0].open);
+                double peak = open;
+                double drawdown = 0.0;
+                for (int i = 0; i < config.minutes; ++i)
+                {
+                    double close = config.instrument.ToPrice(path[i].close);
+                    peak = std::max(peak, close);
+                    if (peak > 0.0) drawdown = std::max(drawdown, (peak - close) / peak * 100.0);
+                }
+                double last = config.instrument.ToPrice(path[config.minutes - 1].close);
+                result.price_return = (open != 0.0) ? (last - open) / open * 100.0 : 0.0;
+                result.max_drawdown = drawdown;
+
+                if (strategy) strategy(first + p, path, config.minutes, result);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < thread_count; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers) w.join();
+
+    summary.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    summary.paths = config.paths;
+    summary.candles = config.paths * (uint64_t)config.minutes;
+
+    // Aggregated serially in path order, so the figures do not depend on the thread count.
+    std::vector<double> returns, pnls;
+    returns.reserve(results.size());
+    pnls.reserve(results.size());
+    uint64_t profitable = 0;
+    double trades = 0.0;
+    double drawdowns = 0.0;
+    for (const PathResult& r : results)
+    {
+        returns.push_back(r.price_return);
+        pnls.push_back(r.pnl);
+        if (r.pnl > 0.0) profitable++;
+        trades += r.trades;
+        drawdowns += r.max_drawdown;
+        summary.worst_drawdown = std::max(summary.worst_drawdown, r.max_drawdown);
+    }
+
+    MeanStddev(returns, summary.mean_return, summary.stddev_return);
+    MeanStddev(pnls, summary.mean_pnl, summary.stddev_pnl);
+    summary.mean_drawdown = drawdowns / results.size();
+    summary.mean_trades = trades / results.size();
+    summary.profitable_fraction = (double)profitable / results.size();
+    summary.return_p05 = Percentile(returns, 0.05);
+    summary.return_p95 = Percentile(returns, 0.95);
+    summary.pnl_p05 = Percentile(pnls, 0.05);
+    summary.pnl_p95 = Percentile(pnls, 0.95);
+    return summary;
+}
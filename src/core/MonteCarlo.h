@@ -0,0 +1,111 @@
+#pragma once
+#include "Models.h"
+#include "MarketDataSource.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+constexpr int PATH_LANES = 8;
+
+// xoshiro256+ for PATH_LANES independent streams, stored lane by lane so one
+// call advances every stream with vector instructions. A stream is seeded
+// from (seed, stream index) alone, so a path draws the same numbers no matter
+// which thread or batch generates it.
+class RandomLanes
+{
+public:
+    void Seed(uint64_t seed, uint64_t first_stream);
+    // One uniform double in [0, 1) per lane.
+    void NextUniform(double* out);
+
+private:
+    uint64_t s0[PATH_LANES];
+    uint64_t s1[PATH_LANES];
+    uint64_t s2[PATH_LANES];
+    uint64_t s3[PATH_LANES];
+};
+
+// Generates independent 1m candle paths with the engine's MarketModel,
+// PATH_LANES paths in lockstep. Path p of a given seed is always the same.
+class PathGenerator
+{
+public:
+    PathGenerator(const MarketModel& model, const Instrument& instrument, uint64_t seed);
+
+    // Writes `minutes` candles for each path in [first_path, first_path + count),
+    // path after path, into out.
+    void Generate(uint64_t first_path, int count, int minutes, Price start_price, double start_time, std::vector<Candle>& out);
+
+private:
+    MarketModel model;
+    Instrument instrument;
+    uint64_t seed;
+    RandomLanes lanes;
+};
+
+// Feeds a generated path to an engine, one candle per Step(), and re-quotes the
+// engine's synthetic book around each close.
+class PathSource : public MarketDataSource
+{
+public:
+    PathSource(const Candle* candles, size_t count);
+    bool Advance(TradingEngine& engine) override;
+
+private:
+    const Candle* candles;
+    size_t count;
+    size_t cursor = 0;
+};
+
+struct MonteCarloConfig
+{
+    uint64_t paths = 10000;
+    int minutes = 1440;
+    // 0 uses one worker per hardware thread.
+    int threads = 0;
+    uint64_t seed = 42;
+    double start_price = 42000.0;
+    double start_time = 0.0;
+    MarketModel model;
+    Instrument instrument;
+};
+
+// Outcome of one path. The strategy fields stay zero when no strategy runs.
+struct PathResult
+{
+    double price_return = 0.0;   // first open to last close, percent
+    double max_drawdown = 0.0;   // largest peak-to-trough fall of the close, percent
+    double pnl = 0.0;            // strategy equity change in quote currency
+    int trades = 0;
+};
+
+// Runs a strategy over one path and fills in the strategy fields of result.
+// Called concurrently from the worker threads.
+using PathStrategy = std::function<void(uint64_t path, const Candle* candles, int minutes, PathResult& result)>;
+
+struct MonteCarloSummary
+{
+    uint64_t paths = 0;
+    uint64_t candles = 0;
+    double elapsed_s = 0.0;
+
+    double mean_return = 0.0;
+    double stddev_return = 0.0;
+    double return_p05 = 0.0;
+    double return_p95 = 0.0;
+    double mean_drawdown = 0.0;
+    double worst_drawdown = 0.0;
+
+    double mean_pnl = 0.0;
+    double stddev_pnl = 0.0;
+    double pnl_p05 = 0.0;
+    double pnl_p95 = 0.0;
+    double profitable_fraction = 0.0;
+    double mean_trades = 0.0;
+};
+
+// Generates config.paths paths across worker threads, runs the strategy (if
+// any) on each and aggregates the per-path results. The summary depends only
+// on the config, not on the number of threads.
+MonteCarloSummary RunMonteCarlo(const MonteCarloConfig& config, const PathStrategy& strategy = nullptr);
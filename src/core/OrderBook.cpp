@@ -0,0 +1,210 @@
+#include "OrderBook.h"
+#include <algorithm>
+
+OrderBook::OrderBook()
+{
+    index.reserve(4096);
+}
+
+bool OrderBook::Add(int64_t id, bool is_buy, Price price, Qty amount, bool is_user)
+{
+    if (amount <= 0 || index.count(id)) return false;
+
+    LevelMap& levels = is_buy ? bid_levels : ask_levels;
+    Price key = is_buy ? -price : price;
+    auto level_it = levels.try_emplace(key, Level{price, 0, 0, -1, -1}).first;
+
+    int32_t slot;
+    if (!free_nodes.empty())
+    {
+        slot = free_nodes.back();
+        free_nodes.pop_back();
+    } else
+    {
+        slot = (int32_t)nodes.size();
+        nodes.emplace_back();
+    }
+
+    nodes[slot] = {id, amount, is_buy, is_user, -1, -1, level_it};
+    PushBack(slot);
+    index.emplace(id, slot);
+    return true;
+}
+
+bool OrderBook::Modify(int64_t id, Qty new_amount)
+{
+    auto it = index.find(id);
+    if (it == index.end()) return false;
+    if (new_amount <= 0) return Cancel(id);
+
+    int32_t slot = it->second;
+    Node& node = nodes[slot];
+    Level& level = node.level->second;
+
+    if (new_amount > node.amount)
+    {
+        Unlink(slot);
+        node.amount = new_amount;
+        PushBack(slot);
+    } else
+    {
+        level.total += new_amount - node.amount;
+        if (node.is_user) level.user_total += new_amount - node.amount;
+        node.amount = new_amount;
+    }
+    return true;
+}
+
+bool OrderBook::Cancel(int64_t id)
+{
+    auto it = index.find(id);
+    if (it == index.end()) return false;
+
+    int32_t slot = it->second;
+    index.erase(it);
+    Unlink(slot);
+    Release(slot);
+    return true;
+}
+
+void OrderBook::Clear()
+{
+    bid_levels.clear();
+    ask_levels.clear();
+    nodes.clear();
+    free_nodes.clear();
+    index.clear();
+}
+
+Qty OrderBook::Match(bool is_buy, Price limit_price, Qty amount, std::vector<BookFill>& fills, std::vector<int64_t>* self_cancels)
+{
+    LevelMap& levels = is_buy ? ask_levels : bid_levels;
+    Qty remaining = amount;
+    Qty filled = 0;
+
+    auto level_it = levels.begin();
+    while (remaining > 0 && level_it != levels.end())
+    {
+        Level& level = level_it->second;
+        if (is_buy ? level.price > limit_price : level.price < limit_price) break;
+
+        int32_t slot = level.head;
+        while (remaining > 0 && slot != -1)
+        {
+            Node& maker = nodes[slot];
+            int32_t next = maker.next;
+            bool self_trade = self_cancels && maker.is_user;
+            if (self_trade)
+            {
+                self_cancels->push_back(maker.id);
+            } else
+            {
+                Qty take = std::min(remaining, maker.amount);
+                fills.push_back({maker.id, maker.is_user, is_buy, level.price, take});
+                remaining -= take;
+                filled += take;
+                maker.amount -= take;
+                level.total -= take;
+                if (maker.is_user) level.user_total -= take;
+            }
+
+            if (self_trade || maker.amount == 0)
+            {
+                // Unlink without Release, which would erase the level under level_it.
+                index.erase(maker.id);
+                Unlink(slot);
+                free_nodes.push_back(slot);
+            }
+            slot = next;
+        }
+
+        if (level.head == -1) level_it = levels.erase(level_it);
+        else ++level_it;
+    }
+
+    return filled;
+}
+
+Qty OrderBook::AvailableVolume(bool is_buy, Price limit_price, Qty max_amount, bool exclude_user) const
+{
+    const LevelMap& levels = is_buy ? ask_levels : bid_levels;
+    Qty available = 0;
+
+    for (const auto& entry : levels)
+    {
+        const Level& level = entry.second;
+        if (is_buy ? level.price > limit_price : level.price < limit_price) break;
+        available += exclude_user ? level.total - level.user_total : level.total;
+        if (available >= max_amount) break;
+    }
+    return available;
+}
+
+void OrderBook::CollectUserOrders(bool is_buy, Price low, Price high, std::vector<int64_t>& ids) const
+{
+    if (low > high) return;
+
+    const LevelMap& levels = is_buy ? bid_levels : ask_levels;
+    Price first_key = is_buy ? -high : low;
+    Price last_key = is_buy ? -low : high;
+
+    for (auto it = levels.lower_bound(first_key); it != levels.end() && it->first <= last_key; ++it)
+    {
+        for (int32_t slot = it->second.head; slot != -1; slot = nodes[slot].next)
+        {
+            if (nodes[slot].is_user) ids.push_back(nodes[slot].id);
+        }
+    }
+}
+
+void OrderBook::GetDepth(int max_levels, std::vector<OrderBookEntry>& bids, std::vector<OrderBookEntry>& asks) const
+{
+    bids.clear();
+    asks.clear();
+
+    for (auto it = bid_levels.begin(); it != bid_levels.end() && (int)bids.size() < max_levels; ++it)
+    {
+        bids.push_back({it->second.price, it->second.total, true});
+    }
+    for (auto it = ask_levels.begin(); it != ask_levels.end() && (int)asks.size() < max_levels; ++it)
+    {
+        asks.push_back({it->second.price, it->second.total, false});
+    }
+}
+
+void OrderBook::PushBack(int32_t slot)
+{
+    Node& node = nodes[slot];
+    Level& level = node.level->second;
+
+    node.prev = level.tail;
+    node.next = -1;
+    if (level.tail != -1) nodes[level.tail].next = slot;
+    else level.head = slot;
+    level.tail = slot;
+    level.total += node.amount;
+    if (node.is_user) level.user_total += node.amount;
+}
+
+void OrderBook::Unlink(int32_t slot)
+{
+    Node& node = nodes[slot];
+    Level& level = node.level->second;
+
+    if (node.prev != -1) nodes[node.prev].next = node.next;
+    else level.head = node.next;
+    if (node.next != -1) nodes[node.next].prev = node.prev;
+    else level.tail = node.prev;
+    level.total -= node.amount;
+    if (node.is_user) level.user_total -= node.amount;
+}
+
+void OrderBook::Release(int32_t slot)
+{
+    Node& node = nodes[slot];
+    if (node.level->second.head == -1)
+    {
+        (node.is_buy ? bid_levels : ask_levels).erase(node.level);
+    }
+    free_nodes.push_back(slot);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Models.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+struct BookFill
+{
+    int64_t maker_id;
+    bool maker_is_user;
+    bool taker_is_buy;
+    Price price;
+    Qty amount;
+};
+
+// Price-time priority limit order book. Each side is a sorted map of price
+// levels, each level a FIFO queue of orders linked through a pooled node array,
+// so add/cancel never search a queue and the best level is always begin().
+class OrderBook
+{
+public:
+    OrderBook();
+
+    bool Add(int64_t id, bool is_buy, Price price, Qty amount, bool is_user);
+    // Reducing the amount keeps queue priority, increasing it sends the order to the back.
+    bool Modify(int64_t id, Qty new_amount);
+    bool Cancel(int64_t id);
+    void Clear();
+
+    // Walks the opposite side up to limit_price and appends one fill per maker touched.
+    // A user taker passes self_cancels: user orders it reaches are cancelled instead of
+    // traded against (self-trade prevention, cancel resting) and their ids appended.
+    Qty Match(bool is_buy, Price limit_price, Qty amount, std::vector<BookFill>& fills, std::vector<int64_t>* self_cancels = nullptr);
+    // Volume on the opposite side up to limit_price; exclude_user leaves out user orders.
+    Qty AvailableVolume(bool is_buy, Price limit_price, Qty max_amount, bool exclude_user = false) const;
+    // Appends the ids of user orders on one side priced within [low, high], best level first.
+    void CollectUserOrders(bool is_buy, Price low, Price high, std::vector<int64_t>& ids) const;
+
+    bool HasBids() const { return !bid_levels.empty(); }
+    bool HasAsks() const { return !ask_levels.empty(); }
+    Price BestBid() const { return bid_levels.begin()->second.price; }
+    Price BestAsk() const { return ask_levels.begin()->second.price; }
+    size_t OrderCount() const { return index.size(); }
+
+    void GetDepth(int max_levels, std::vector<OrderBookEntry>& bids, std::vector<OrderBookEntry>& asks) const;
+
+private:
+    struct Level
+    {
+        Price price;
+        Qty total;
+        Qty user_total;
+        int32_t head;
+        int32_t tail;
+    };
+
+    // Bids are keyed by -price so that both maps iterate best level first.
+    using LevelMap = std::map<Price, Level>;
+
+    struct Node
+    {
+        int64_t id;
+        Qty amount;
+        bool is_buy;
+        bool is_user;
+        int32_t prev;
+        int32_t next;
+        LevelMap::iterator level;
+    };
+
+    LevelMap bid_levels;
+    LevelMap ask_levels;
+    std::vector<Node> nodes;
+    std::vector<int32_t> free_nodes;
+    std::unordered_map<int64_t, int32_t> index;
+
+    void PushBack(int32_t slot);
+    void Unlink(int32_t slot);
+    void Release(int32_t slot);
+};
@@ -0,0 +1,96 @@
+#include "PerformanceStats.h"
+#include <algorithm>
+#include <cmath>
+
+double RunningStats::StdDev() const
+{
+    return std::sqrt(Variance());
+}
+
+void RollingStats::Add(double x)
+{
+    size_t n = samples.Size();
+    if (n < samples.Capacity())
+    {
+        double delta = x - mean;
+        mean += delta / (n + 1);
+        m2 += delta * (x - mean);
+    } else if (n > 0)
+    {
+        // Replace the oldest sample: same count, so mean and M2 shift in one step.
+        double old = samples.Front();
+        double old_mean = mean;
+        mean += (x - old) / n;
+        m2 += (x - old) * (x - mean + old - old_mean);
+    }
+    samples.PushBack(x);
+}
+
+void RollingStats::Reset()
+{
+    samples.Clear();
+    mean = 0.0;
+    m2 = 0.0;
+}
+
+double RollingStats::Variance() const
+{
+    size_t n = samples.Size();
+    // Rounding in the sliding update can leave M2 a hair below zero.
+    return (n > 1) ? std::max(m2, 0.0) / (n - 1) : 0.0;
+}
+
+double RollingStats::StdDev() const
+{
+    return std::sqrt(Variance());
+}
+
+PerformanceTracker::PerformanceTracker() : hour_returns(HOUR), day_returns(DAY) {}
+
+void PerformanceTracker::Reset()
+{
+    returns.Reset();
+    hour_returns.Reset();
+    day_returns.Reset();
+    downside_sq = 0.0;
+    last_equity = 0.0;
+    has_equity = false;
+}
+
+void PerformanceTracker::AddEquity(double equity)
+{
+    if (has_equity && last_equity > 0.0)
+    {
+        double r = equity / last_equity - 1.0;
+        returns.Add(r);
+        hour_returns.Add(r);
+        day_returns.Add(r);
+        if (r < 0.0) downside_sq += r * r;
+    }
+    last_equity = equity;
+    has_equity = true;
+}
+
+void PerformanceTracker::Summarize(const TradingState& state, PerformanceSummary& out) const
+{
+    const double annualize = std::sqrt(PERIODS_PER_YEAR);
+
+    out.samples = returns.Count();
+    double mean = returns.Mean();
+    double stddev = returns.StdDev();
+    double downside = (out.samples > 0) ? std::sqrt(downside_sq / out.samples) : 0.0;
+
+    // Arithmetic annualization, so short runs do not compound into overflow.
+    out.annual_return = mean * PERIODS_PER_YEAR * 100.0;
+    out.sharpe = (stddev > 0.0) ? mean / stddev * annualize : 0.0;
+    out.sortino = (downside > 0.0) ? mean / downside * annualize : 0.0;
+    out.calmar = (state.max_drawdown > 0.0) ? out.annual_return / state.max_drawdown : 0.0;
+    out.volatility = stddev * annualize * 100.0;
+    out.volatility_1h = hour_returns.StdDev() * annualize * 100.0;
+    out.volatility_1d = day_returns.StdDev() * annualize * 100.0;
+
+    const Instrument& inst = state.instrument;
+    out.avg_win = (state.winning_trades > 0) ? inst.ToValue(state.gross_profit) / state.winning_trades : 0.0;
+    out.avg_loss = (state.losing_trades > 0) ? inst.ToValue(state.gross_loss) / state.losing_trades : 0.0;
+    out.expectancy = (state.total_trades_count > 0) ? inst.ToValue(state.gross_profit - state.gross_loss) / state.total_trades_count : 0.0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Models.h"
+#include "RingBuffer.h"
+#include <cstddef>
+#include <cstdint>
+
+// Streaming mean and variance (Welford). O(1) per sample and numerically
+// stable over millions of samples.
+class RunningStats
+{
+public:
+    void Add(double x)
+    {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+
+    void Reset() { count = 0; mean = 0.0; m2 = 0.0; }
+
+    uint64_t Count() const { return count; }
+    double Mean() const { return mean; }
+    // Sample variance; 0 until there are two samples.
+    double Variance() const { return (count > 1) ? m2 / (count - 1) : 0.0; }
+    double StdDev() const;
+
+private:
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+};
+
+// Mean and variance of the last Window() samples. The sample leaving the
+// window is read back from a ring buffer, so each Add is O(1).
+class RollingStats
+{
+public:
+    explicit RollingStats(size_t window) : samples(window) {}
+
+    void Add(double x);
+    void Reset();
+
+    size_t Count() const { return samples.Size(); }
+    size_t Window() const { return samples.Capacity(); }
+    double Mean() const { return mean; }
+    double Variance() const;
+    double StdDev() const;
+
+private:
+    RingBuffer<double> samples;
+    double mean = 0.0;
+    double m2 = 0.0;
+};
+
+// Risk and return figures over an equity curve sampled once per 1m candle,
+// plus per-trade figures from the account's running totals. Nothing here
+// rescans equity_history; every update is O(1).
+class PerformanceTracker
+{
+public:
+    // Annualization assumes one sample per minute, around the clock.
+    static constexpr double PERIODS_PER_YEAR = 365.0 * 24.0 * 60.0;
+    static constexpr size_t HOUR = 60;
+    static constexpr size_t DAY = 24 * 60;
+
+    PerformanceTracker();
+
+    void Reset();
+    // Equity in quote currency at the close of a candle. Returns are taken
+    // against the previous sample and skipped while that is not positive.
+    void AddEquity(double equity);
+    void Summarize(const TradingState& state, PerformanceSummary& out) const;
+
+private:
+    RunningStats returns;
+    RollingStats hour_returns;
+    RollingStats day_returns;
+    // Sum of squared negative returns, for downside deviation (target 0).
+    double downside_sq = 0.0;
+    double last_equity = 0.0;
+    bool has_equity = false;
+};
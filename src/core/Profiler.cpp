@@ -0,0 +1,127 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+    struct alignas(64) StageRing
+    {
+        std::atomic<uint64_t> next{0};
+        std::atomic<uint32_t> ns[Profiler::WINDOW];
+    };
+
+    StageRing rings[PROF_STAGE_COUNT];
+    std::atomic<uint64_t> ticks{0};
+
+    const char* const STAGE_NAMES[PROF_STAGE_COUNT] =
+    {
+        "Engine Update",
+        "GenerateMarketData",
+        "CheckLimitOrders",
+        "UpdateAccount",
+        "GetCandles",
+        "Render (all windows)",
+        "RenderChart",
+        "RenderOrderBook",
+        "RenderRecentTrades",
+        "RenderOrderEntry",
+        "RenderEquityWindow",
+        "RenderTerminal",
+        "RenderPerformance",
+        "ImGui/GL Render",
+        "Swap Buffers",
+        "Frame"
+    };
+
+    // Newest samples of a stage, oldest first.
+    size_t CopySamples(ProfileStage stage, uint32_t* out, size_t max)
+    {
+        const StageRing& ring = rings[stage];
+        uint64_t end = ring.next.load(std::memory_order_acquire);
+        size_t count = (size_t)std::min<uint64_t>(std::min(end, (uint64_t)Profiler::WINDOW), max);
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = ring.ns[(end - count + i) % Profiler::WINDOW].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+}
+
+bool Profiler::Enabled()
+{
+#ifdef TRADEUI_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* Profiler::StageName(ProfileStage stage)
+{
+    return (stage >= 0 && stage < PROF_STAGE_COUNT) ? STAGE_NAMES[stage] : "?";
+}
+
+void Profiler::Record(ProfileStage stage, uint64_t ns)
+{
+    StageRing& ring = rings[stage];
+    uint64_t slot = ring.next.fetch_add(1, std::memory_order_relaxed) % WINDOW;
+    ring.ns[slot].store((uint32_t)std::min<uint64_t>(ns, UINT32_MAX), std::memory_order_relaxed);
+}
+
+void Profiler::CountTick()
+{
+    ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+ProfileStats Profiler::Summarize(ProfileStage stage)
+{
+    uint32_t samples[WINDOW];
+    size_t count = CopySamples(stage, samples, WINDOW);
+
+    ProfileStats stats;
+    stats.samples = count;
+    if (count == 0) return stats;
+
+    uint64_t sum = 0;
+    uint32_t min = samples[0];
+    for (size_t i = 0; i < count; ++i)
+    {
+        sum += samples[i];
+        min = std::min(min, samples[i]);
+    }
+    size_t k = (size_t)(0.99 * (count - 1));
+    std::nth_element(samples, samples + k, samples + count);
+
+    stats.min_us = min / 1000.0;
+    stats.avg_us = (double)sum / count / 1000.0;
+    stats.p99_us = samples[k] / 1000.0;
+    return stats;
+}
+
+size_t Profiler::History(ProfileStage stage, float* out_ms, size_t max)
+{
+    uint32_t samples[WINDOW];
+    size_t count = CopySamples(stage, samples, std::min(max, WINDOW));
+    for (size_t i = 0; i < count; ++i) out_ms[i] = samples[i] / 1e6f;
+    return count;
+}
+
+double Profiler::TicksPerSecond()
+{
+    // Refreshed at most twice a second so short frames do not make it jitter.
+    static auto last_time = std::chrono::steady_clock::now();
+    static uint64_t last_ticks = 0;
+    static double rate = 0.0;
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_time).count();
+    if (elapsed >= 0.5)
+    {
+        uint64_t current = ticks.load(std::memory_order_relaxed);
+        rate = (current - last_ticks) / elapsed;
+        last_ticks = current;
+        last_time = now;
+    }
+    return rate;
+}
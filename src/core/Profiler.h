@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hot-path stage timings for the Performance window. PROFILE_SCOPE(stage)
+// times the rest of the enclosing block and PROFILE_TICK() counts an engine
+// tick. Both expand to nothing unless TRADEUI_PROFILE is defined (the
+// TRADEUI_PROFILE CMake option), so a build without it carries no timers.
+enum ProfileStage
+{
+    PROF_ENGINE_UPDATE = 0,
+    PROF_GENERATE_MARKET_DATA,
+    PROF_CHECK_LIMIT_ORDERS,
+    PROF_UPDATE_ACCOUNT,
+    PROF_GET_CANDLES,
+    PROF_RENDER_UI,
+    PROF_RENDER_CHART,
+    PROF_RENDER_ORDER_BOOK,
+    PROF_RENDER_RECENT_TRADES,
+    PROF_RENDER_ORDER_ENTRY,
+    PROF_RENDER_EQUITY,
+    PROF_RENDER_TERMINAL,
+    PROF_RENDER_PERFORMANCE,
+    PROF_GL_RENDER,
+    PROF_SWAP_BUFFERS,
+    PROF_FRAME,
+    PROF_STAGE_COUNT
+};
+
+struct ProfileStats
+{
+    double min_us = 0.0;
+    double avg_us = 0.0;
+    double p99_us = 0.0;
+    size_t samples = 0;
+};
+
+// Keeps the last WINDOW durations of every stage in a ring. Any thread may
+// record; each sample claims its own slot, so writers never wait. Readers
+// may see a slot mid-update, which only skews one displayed sample.
+class Profiler
+{
+public:
+    static constexpr size_t WINDOW = 512;
+
+    static bool Enabled();
+    static const char* StageName(ProfileStage stage);
+
+    static void Record(ProfileStage stage, uint64_t ns);
+    static void CountTick();
+
+    static ProfileStats Summarize(ProfileStage stage);
+    // Copies up to `max` of the newest durations, oldest first, in milliseconds.
+    static size_t History(ProfileStage stage, float* out_ms, size_t max);
+    // Engine ticks per second over roughly the last half second. UI thread only.
+    static double TicksPerSecond();
+};
+
+#ifdef TRADEUI_PROFILE
+#include <chrono>
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Profiler::Record(stage, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+#define PROFILE_TICK() Profiler::CountTick()
+#else
+#define PROFILE_SCOPE(stage) do {} while (0)
+#define PROFILE_TICK() do {} while (0)
+#endif
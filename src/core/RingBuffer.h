@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lineage ids for ring buffers: a copy keeps its source's id, so copy
+// assignment can tell whether only newly appended elements need copying.
+inline uint64_t NextRingGeneration()
+{
+    static std::atomic<uint64_t> counter{1};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Fixed-capacity ring buffer over contiguous storage. PushBack is O(1) and
+// evicts the oldest element once full. Element i of the logical sequence
+// (0 = oldest) always lives in slot (sequence number % capacity), so the
+// storage is at most two contiguous runs and can be handed to ImPlot as
+// Data()/Size()/Offset() without copying.
+//
+// Only the newest element may be modified in place (through Back()). Copy
+// assignment between buffers of the same lineage relies on that and copies
+// just the elements appended since the last assignment, which keeps
+// TradingState snapshots cheap even with very large histories.
+template <typename T>
+class RingBuffer
+{
+public:
+    struct Span
+    {
+        const T* data;
+        size_t size;
+    };
+
+    RingBuffer() : RingBuffer(0) {}
+    explicit RingBuffer(size_t capacity) : capacity(capacity), generation(NextRingGeneration()) {}
+
+    RingBuffer(const RingBuffer&) = default;
+    RingBuffer(RingBuffer&&) = default;
+    RingBuffer& operator=(RingBuffer&&) = default;
+
+    RingBuffer& operator=(const RingBuffer& other)
+    {
+        if (this == &other) return *this;
+
+        if (generation != other.generation || capacity != other.capacity || pushed > other.pushed)
+        {
+            storage = other.storage;
+            capacity = other.capacity;
+            generation = other.generation;
+            pushed = other.pushed;
+            return *this;
+        }
+
+        if (storage.size() < other.storage.size()) storage.resize(other.storage.size());
+
+        uint64_t oldest = other.pushed - other.Size();
+        uint64_t first = (pushed > 0) ? pushed - 1 : 0;
+        if (first < oldest) first = oldest;
+
+        for (uint64_t seq = first; seq < other.pushed; ++seq)
+        {
+            size_t slot = (size_t)(seq % capacity);
+            storage[slot] = other.storage[slot];
+        }
+        pushed = other.pushed;
+        return *this;
+    }
+
+    void SetCapacity(size_t new_capacity)
+    {
+        capacity = new_capacity;
+        Clear();
+    }
+
+    void Clear()
+    {
+        storage.clear();
+        pushed = 0;
+        generation = NextRingGeneration();
+    }
+
+    void PushBack(const T& value)
+    {
+        if (capacity == 0) return;
+        if (storage.size() < capacity) storage.push_back(value);
+        else storage[(size_t)(pushed % capacity)] = value;
+        ++pushed;
+    }
+
+    size_t Size() const { return storage.size(); }
+    size_t Capacity() const { return capacity; }
+    bool Empty() const { return storage.empty(); }
+    uint64_t TotalPushed() const { return pushed; }
+    // Identifies the lineage: copies share it, Clear and SetCapacity start a new one.
+    uint64_t Generation() const { return generation; }
+
+    const T& operator[](size_t i) const { return storage[(Offset() + i) % storage.size()]; }
+    const T& Front() const { return storage[Offset()]; }
+    const T& Back() const { return storage[(size_t)((pushed - 1) % capacity)]; }
+    T& Back() { return storage[(size_t)((pushed - 1) % capacity)]; }
+
+    // Raw storage plus the slot of the oldest element, matching ImPlot's offset argument.
+    const T* Data() const { return storage.data(); }
+    size_t Offset() const { return (storage.size() < capacity) ? 0 : (size_t)(pushed % capacity); }
+
+    // Oldest-first contiguous runs; Second() is empty until the buffer wraps.
+    Span First() const { return {storage.data() + Offset(), storage.size() - Offset()}; }
+    Span Second() const { return {storage.data(), Offset()}; }
+
+private:
+    std::vector<T> storage;
+    size_t capacity = 0;
+    uint64_t generation = 0;
+    uint64_t pushed = 0;
+};
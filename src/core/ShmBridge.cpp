@@ -0,0 +1,328 @@
+#include "ShmBridge.h"
+#include "SpscQueue.h"
+#include "TradingEngine.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct BridgeSegment
+{
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> consumer;
+    std::atomic<uint32_t> host_closed;
+    int32_t host_pid;
+    // 0 until the attached dashboard has stored its pid.
+    std::atomic<int32_t> consumer_pid;
+    uint32_t event_size;
+    uint32_t order_size;
+    SpscQueue<BridgeEvent, BRIDGE_EVENT_CAPACITY> events;
+    SpscQueue<OrderRequest, BRIDGE_ORDER_CAPACITY> orders;
+};
+
+namespace
+{
+    constexpr uint32_t BRIDGE_MAGIC = 0x42495554;  // "TUIB"
+
+    enum ConsumerState : uint32_t
+    {
+        CONSUMER_NONE = 0,
+        CONSUMER_ATTACHED = 1,
+        CONSUMER_DETACHED = 2
+    };
+
+    static_assert(std::atomic<size_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+        "bridge rings need address-free atomics");
+
+    inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    std::string ShmName(const std::string& name)
+    {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+    bool ProcessAlive(int32_t pid)
+    {
+        return ::kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    BridgeSegment* Map(int fd)
+    {
+        void* mapping = mmap(nullptr, sizeof(BridgeSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        return (mapping == MAP_FAILED) ? nullptr : (BridgeSegment*)mapping;
+    }
+}
+
+ShmBridge::ShmBridge() {}
+
+ShmBridge::~ShmBridge()
+{
+    Close();
+}
+
+bool ShmBridge::Open(const std::string& name)
+{
+    Close();
+
+    fd = shm_open(ShmName(name).c_str(), O_RDWR, 0);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != sizeof(BridgeSegment) || !(segment = Map(fd)))
+    {
+        Close();
+        return false;
+    }
+
+    uint32_t expected = CONSUMER_NONE;
+    if (segment->magic.load(std::memory_order_acquire) != BRIDGE_MAGIC || segment->event_size != sizeof(BridgeEvent) ||
+        segment->order_size != sizeof(OrderRequest) ||
+        !segment->consumer.compare_exchange_strong(expected, CONSUMER_ATTACHED, std::memory_order_acq_rel))
+    {
+        munmap(segment, sizeof(BridgeSegment));
+        segment = nullptr;
+        Close();
+        return false;
+    }
+
+    segment->consumer_pid.store((int32_t)::getpid(), std::memory_order_release);
+    ended = false;
+    host_lost = false;
+    next_host_check = std::chrono::steady_clock::now();
+    events_received = orders_sent = orders_refused = 0;
+    return true;
+}
+
+void ShmBridge::Close()
+{
+    if (segment)
+    {
+        segment->consumer.store(CONSUMER_DETACHED, std::memory_order_release);
+        munmap(segment, sizeof(BridgeSegment));
+        segment = nullptr;
+    }
+    if (fd != -1)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool ShmBridge::Advance(TradingEngine& engine)
+{
+    if (!segment || ended) return false;
+
+    BridgeEvent event;
+    for (;;)
+    {
+        if (!segment->events.TryPop(event))
+        {
+            // Checked after the ring is drained, so nothing published before closing is lost.
+            if (segment->host_closed.load(std::memory_order_acquire) || !HostAlive())
+            {
+                ended = true;
+                return false;
+            }
+            if (!wait) return true;
+            CpuRelax();
+            continue;
+        }
+
+        events_received++;
+        if (event.type == BRIDGE_EXECUTION)
+        {
+            engine.ApplyExecution(event.execution);
+        }
+        else if (event.type == BRIDGE_MARKET)
+        {
+            ApplyMarketRecord(engine, event.market);
+            if (event.market.type == MD_CANDLE) return true;
+        }
+        else if (event.type == BRIDGE_END)
+        {
+            ended = true;
+            return false;
+        }
+    }
+}
+
+bool ShmBridge::HostAlive()
+{
+    // Only checked while idle, and at most every PEER_CHECK_MS, so the data path makes no system call.
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_host_check) return true;
+    next_host_check = now + std::chrono::milliseconds(PEER_CHECK_MS);
+
+    if (ProcessAlive(segment->host_pid)) return true;
+    host_lost = true;
+    return false;
+}
+
+bool ShmBridge::Send(const OrderRequest& request)
+{
+    if (!segment || !segment->orders.TryPush(request))
+    {
+        orders_refused++;
+        return false;
+    }
+    orders_sent++;
+    return true;
+}
+
+ShmBridgeHost::ShmBridgeHost() {}
+
+ShmBridgeHost::~ShmBridgeHost()
+{
+    Close();
+}
+
+bool ShmBridgeHost::Create(const std::string& name)
+{
+    Close();
+
+    shm_name = ShmName(name);
+    shm_unlink(shm_name.c_str());
+    fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) return false;
+
+    if (ftruncate(fd, sizeof(BridgeSegment)) != 0 || !(segment = Map(fd)))
+    {
+        Close();
+        return false;
+    }
+
+    // The fresh mapping is zeroed; the magic is published last so a dashboard never sees a half-built segment.
+    new (segment) BridgeSegment();
+    segment->event_size = sizeof(BridgeEvent);
+    segment->order_size = sizeof(OrderRequest);
+    segment->host_pid = (int32_t)::getpid();
+    segment->magic.store(BRIDGE_MAGIC, std::memory_order_release);
+
+    events_sent = events_dropped = 0;
+    next_consumer_check = std::chrono::steady_clock::now();
+    return true;
+}
+
+void ShmBridgeHost::Close()
+{
+    if (segment)
+    {
+        segment->host_closed.store(1, std::memory_order_release);
+        munmap(segment, sizeof(BridgeSegment));
+        segment = nullptr;
+    }
+    if (fd != -1)
+    {
+        ::close(fd);
+        fd = -1;
+        shm_unlink(shm_name.c_str());
+    }
+}
+
+void ShmBridgeHost::Push(const BridgeEvent& event)
+{
+    if (!segment) return;
+    while (!segment->events.TryPush(event))
+    {
+        if (ConsumerDetached() || !ConsumerAlive())
+        {
+            events_dropped++;
+            return;
+        }
+        CpuRelax();
+    }
+    events_sent++;
+}
+
+void ShmBridgeHost::WriteCandle(const Candle& candle)
+{
+    BridgeEvent event = {};
+    event.type = BRIDGE_MARKET;
+    event.market.time = candle.time;
+    event.market.type = MD_CANDLE;
+    event.market.price = candle.open;
+    event.market.high = candle.high;
+    event.market.low = candle.low;
+    event.market.close = candle.close;
+    event.market.volume = candle.volume;
+    Push(event);
+}
+
+void ShmBridgeHost::WriteTrade(const Trade& trade)
+{
+    BridgeEvent event = {};
+    event.type = BRIDGE_MARKET;
+    event.market.time = trade.time;
+    event.market.type = MD_TRADE;
+    event.market.is_buy = trade.is_buy ? 1 : 0;
+    event.market.price = trade.price;
+    event.market.volume = trade.amount;
+    Push(event);
+}
+
+void ShmBridgeHost::WriteBook(double time, bool is_bid, Price price, Qty volume)
+{
+    BridgeEvent event = {};
+    event.type = BRIDGE_MARKET;
+    event.market.time = time;
+    event.market.type = MD_BOOK;
+    event.market.is_buy = is_bid ? 1 : 0;
+    event.market.price = price;
+    event.market.volume = volume;
+    Push(event);
+}
+
+void ShmBridgeHost::WriteExecution(const ExecutionReport& report)
+{
+    BridgeEvent event = {};
+    event.type = BRIDGE_EXECUTION;
+    event.execution = report;
+    Push(event);
+}
+
+void ShmBridgeHost::Finish()
+{
+    BridgeEvent event = {};
+    event.type = BRIDGE_END;
+    Push(event);
+}
+
+bool ShmBridgeHost::ConsumerAlive()
+{
+    // Same rate limit as ShmBridge::HostAlive; only reached while the ring is full.
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_consumer_check) return true;
+    next_consumer_check = now + std::chrono::milliseconds(PEER_CHECK_MS);
+
+    int32_t pid = segment->consumer_pid.load(std::memory_order_acquire);
+    if (pid == 0 || ProcessAlive(pid)) return true;
+    // A dead dashboard is treated as detached, so later writes drop at once.
+    segment->consumer.store(CONSUMER_DETACHED, std::memory_order_release);
+    return false;
+}
+
+bool ShmBridgeHost::PollOrder(OrderRequest& out)
+{
+    return segment && segment->orders.TryPop(out);
+}
+
+bool ShmBridgeHost::ConsumerAttached() const
+{
+    return segment && segment->consumer.load(std::memory_order_acquire) == CONSUMER_ATTACHED;
+}
+
+bool ShmBridgeHost::ConsumerDetached() const
+{
+    return segment && segment->consumer.load(std::memory_order_acquire) == CONSUMER_DETACHED;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "MarketDataSource.h"
+#include "Models.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bridge to a matching engine in another process on the same host, through a
+// POSIX shared memory segment holding two single-producer/single-consumer
+// rings: market data and execution reports towards the dashboard, order
+// requests towards the engine. The engine side creates the segment and one
+// dashboard attaches to it. Both sides only read and write the mapping on the
+// data path; a side that waits for a ring spins on it. While it spins, each
+// side checks every PEER_CHECK_MS that the other process is still alive, so a
+// crashed peer ends the session instead of hanging it.
+
+enum BridgeEventType : uint8_t
+{
+    BRIDGE_MARKET = 1,
+    BRIDGE_EXECUTION = 2,
+    BRIDGE_END = 3
+};
+
+struct BridgeEvent
+{
+    uint8_t type;
+    uint8_t reserved[7];
+    union
+    {
+        MarketRecord market;
+        ExecutionReport execution;
+    };
+};
+
+static_assert(sizeof(BridgeEvent) == 64, "bridge events must stay one cache line");
+
+constexpr size_t BRIDGE_EVENT_CAPACITY = 1 << 16;
+constexpr size_t BRIDGE_ORDER_CAPACITY = 1 << 12;
+constexpr const char* DEFAULT_BRIDGE = "/tradeui-bridge";
+constexpr int PEER_CHECK_MS = 100;
+
+struct BridgeSegment;
+
+// Dashboard side: a market data source that also routes the engine's orders.
+// Advance applies events up to and including the next candle; when the ring
+// runs dry it returns, or with wait set spins until the candle arrives.
+class ShmBridge : public MarketDataSource, public OrderGateway
+{
+public:
+    ShmBridge();
+    ~ShmBridge() override;
+
+    ShmBridge(const ShmBridge&) = delete;
+    ShmBridge& operator=(const ShmBridge&) = delete;
+
+    // Fails if no engine has created the segment or another dashboard is attached.
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return segment != nullptr; }
+
+    // Returns false once the engine has ended the session, closed the segment or died.
+    bool Advance(TradingEngine& engine) override;
+    bool Send(const OrderRequest& request) override;
+
+    bool wait = false;
+
+    uint64_t EventsReceived() const { return events_received; }
+    uint64_t OrdersSent() const { return orders_sent; }
+    uint64_t OrdersRefused() const { return orders_refused; }
+    // The engine process exited without closing the segment.
+    bool HostLost() const { return host_lost; }
+
+private:
+    int fd = -1;
+    BridgeSegment* segment = nullptr;
+    bool ended = false;
+    bool host_lost = false;
+    std::chrono::steady_clock::time_point next_host_check;
+    uint64_t events_received = 0;
+    uint64_t orders_sent = 0;
+    uint64_t orders_refused = 0;
+
+    bool HostAlive();
+};
+
+// Engine side: creates the segment, publishes market data with the Write*
+// calls of MarketDataWriter plus execution reports, and polls order requests.
+// Writers spin while the event ring is full and a dashboard is attached (or
+// has yet to attach); once it has detached or died, events are dropped.
+class ShmBridgeHost
+{
+public:
+    ShmBridgeHost();
+    ~ShmBridgeHost();
+
+    ShmBridgeHost(const ShmBridgeHost&) = delete;
+    ShmBridgeHost& operator=(const ShmBridgeHost&) = delete;
+
+    // Replaces any segment left under the same name.
+    bool Create(const std::string& name);
+    // Tells the dashboard the segment is going away, then unlinks it.
+    void Close();
+    bool IsOpen() const { return segment != nullptr; }
+
+    void WriteCandle(const Candle& candle);
+    void WriteTrade(const Trade& trade);
+    void WriteBook(double time, bool is_bid, Price price, Qty volume);
+    void WriteExecution(const ExecutionReport& report);
+    // Tells the dashboard the session is over.
+    void Finish();
+
+    bool PollOrder(OrderRequest& out);
+    bool ConsumerAttached() const;
+    bool ConsumerDetached() const;
+
+    uint64_t EventsSent() const { return events_sent; }
+    uint64_t EventsDropped() const { return events_dropped; }
+
+private:
+    int fd = -1;
+    BridgeSegment* segment = nullptr;
+    std::string shm_name;
+    uint64_t events_sent = 0;
+    uint64_t events_dropped = 0;
+    std::chrono::steady_clock::time_point next_consumer_check;
+
+    void Push(const BridgeEvent& event);
+    bool ConsumerAlive();
+};
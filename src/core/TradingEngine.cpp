@@ -1,21 +1,68 @@
 #include "TradingEngine.h"
+#include "CandleStore.h"
+#include "Journal.h"
+#include "MarketDataSource.h"
+#include "Profiler.h"
 #include <chrono>
 #include <algorithm>
 #include <cmath>
-#include <iostream>
+#include <cstring>
+#include <limits>
 
-TradingEngine::TradingEngine() {}
+namespace
+{
+    constexpr int BOOK_DEPTH = 15;
+    constexpr int64_t SYNTHETIC_ID_BASE = 1LL << 40;
+
+    int64_t DoubleBits(double value)
+    {
+        int64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    uint8_t JournalFlagsFor(bool is_buy, bool reduce_only)
+    {
+        return (uint8_t)((is_buy ? JF_BUY : 0) | (reduce_only ? JF_REDUCE_ONLY : 0));
+    }
+}
+
+TradingEngine::TradingEngine()
+{
+    synthetic_id_counter = SYNTHETIC_ID_BASE;
+}
 
 void TradingEngine::Init()
 {
-    state.rng.seed(std::random_device{}());
-    
+    Init(std::random_device{}());
+}
+
+void TradingEngine::Init(uint32_t seed)
+{
     double now = (double)std::chrono::duration_cast<std::chrono::seconds>
     (
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
+
+    Init(seed, now);
+}
+
+void TradingEngine::Init(uint32_t seed, double now)
+{
+    if (journal) journal->Append(EVT_INIT, 0, seed, DoubleBits(now));
+    rng.seed(seed);
+    performance.Reset();
+    sampled_candles = 0;
+    market_time = 0.0;
+
+    if (market_source)
+    {
+        state.equity_history.PushBack(state.instrument.ToValue(state.equity));
+        return;
+    }
     
-    double price = 42000.0;
+    const Instrument& inst = state.instrument;
+    Price price = state.current_price;
     std::normal_distribution<double> walk(0.0, 50.0);
     std::uniform_real_distribution<double> noise(0.0, 15.0);
     std::uniform_real_distribution<double> vol(1.0, 100.0);
@@ -26,100 +73,79 @@ void TradingEngine::Init()
     for (int i = 0; i < 200; ++i)
     {
         double t = start_time + (i * time_step);
-        double move = walk(state.rng);
-        double open = price;
-        double close = open + move;
-        double high = std::max(open, close) + noise(state.rng);
-        double low = std::min(open, close) - noise(state.rng);
+        Price move = inst.ToTicks(walk(rng));
+        Price open = price;
+        Price close = open + move;
+        Price high = std::max(open, close) + inst.ToTicks(noise(rng));
+        Price low = std::min(open, close) - inst.ToTicks(noise(rng));
         
-        state.candles.push_back({t, open, high, low, close, vol(state.rng)});
+        AppendCandle({t, open, high, low, close, inst.ToLots(vol(rng))});
         price = close;
     }
     state.current_price = price;
-    state.order_price = (float)price;
+    QuoteSyntheticBook();
     
-    state.equity_history.push_back(state.equity);
+    state.equity_history.PushBack(state.instrument.ToValue(state.equity));
 }
 
-std::vector<Candle> TradingEngine::GetCandles(int timeframe_idx) const
+const CandleSeries& TradingEngine::GetCandles(const TradingState& state, int timeframe_idx)
 {
-    int minutes = 1;
-    switch(timeframe_idx)
-        {
-        case 0: minutes = 1; break;
-        case 1: minutes = 5; break;
-        case 2: minutes = 15; break;
-        case 3: minutes = 60; break;
-        case 4: minutes = 240; break;
-        case 5: minutes = 1440; break;
-        default: minutes = 1; break;
-    }
-
-    if (minutes == 1 || state.candles.empty())
-        {
-        return state.candles;
-    }
+    PROFILE_SCOPE(PROF_GET_CANDLES);
+    if (timeframe_idx <= 0 || timeframe_idx >= TIMEFRAME_COUNT) return state.candles;
+    return state.aggregated_candles[timeframe_idx];
+}
 
-    std::vector<Candle> aggregated;
-    double group_seconds = minutes * 60.0;
-    
-    Candle current_candle = {};
-    bool first = true;
-    double bucket_start_time = 0.0;
+void TradingEngine::AppendCandle(const Candle& candle)
+{
+    state.candles.PushBack(candle);
+    AdvanceMarketTime(candle.time);
+    if (candle_archive) candle_archive->Append(candle);
 
-    for (const auto& c : state.candles)
+    for (int tf = 1; tf < TIMEFRAME_COUNT; ++tf)
     {
-        double t = c.time;
-        double bucket = std::floor(t / group_seconds) * group_seconds;
+        auto& series = state.aggregated_candles[tf];
+        double group_seconds = TIMEFRAME_MINUTES[tf] * 60.0;
+        double bucket = std::floor(candle.time / group_seconds) * group_seconds;
 
-        if (first)
+        if (!series.Empty() && series.Times()[series.BackSlot()] == bucket)
         {
-            bucket_start_time = bucket;
-            current_candle = c;
-            current_candle.time = bucket;
-            first = false;
+            Candle open_bucket = series.Back();
+            open_bucket.high = std::max(open_bucket.high, candle.high);
+            open_bucket.low = std::min(open_bucket.low, candle.low);
+            open_bucket.close = candle.close;
+            open_bucket.volume += candle.volume;
+            series.UpdateBack(open_bucket);
         } else
         {
-            if (bucket != bucket_start_time)
-            {
-                aggregated.push_back(current_candle);
-                bucket_start_time = bucket;
-                current_candle = c;
-                current_candle.time = bucket;
-            } else
-            {
-                current_candle.high = std::max(current_candle.high, c.high);
-                current_candle.low = std::min(current_candle.low, c.low);
-                current_candle.close = c.close;
-                current_candle.volume += c.volume;
-            }
+            Candle opened = candle;
+            opened.time = bucket;
+            series.PushBack(opened);
         }
     }
-
-    if (!first)
-    {
-        aggregated.push_back(current_candle);
-    }
-
-    return aggregated;
 }
 
 void TradingEngine::UpdateAccount()
 {
-    if (state.long_pos.amount > 0.0)
+    MarkToMarket();
+    state.equity_history.PushBack(state.instrument.ToValue(state.equity));
+}
+
+void TradingEngine::MarkToMarket()
+{
+    if (state.long_pos.amount > 0)
     {
-        state.long_pos.unrealized_pnl = (state.current_price - state.long_pos.entry_price) * state.long_pos.amount;
+        state.long_pos.unrealized_pnl = state.current_price * state.long_pos.amount - state.long_pos.entry_cost;
     } else
     {
-        state.long_pos.unrealized_pnl = 0.0;
+        state.long_pos.unrealized_pnl = 0;
     }
 
-    if (state.short_pos.amount < 0.0)
+    if (state.short_pos.amount < 0)
     {
-        state.short_pos.unrealized_pnl = (state.current_price - state.short_pos.entry_price) * state.short_pos.amount;
+        state.short_pos.unrealized_pnl = state.short_pos.entry_cost + state.current_price * state.short_pos.amount;
     } else
     {
-        state.short_pos.unrealized_pnl = 0.0;
+        state.short_pos.unrealized_pnl = 0;
     }
 
     state.equity = state.balance + state.long_pos.unrealized_pnl + state.short_pos.unrealized_pnl;
@@ -127,268 +153,606 @@ void TradingEngine::UpdateAccount()
     if (state.equity > state.max_equity) state.max_equity = state.equity;
     if (state.max_equity > 0)
     {
-        double dd = (state.max_equity - state.equity) / state.max_equity * 100.0;
+        double dd = (double)(state.max_equity - state.equity) / state.max_equity * 100.0;
         if (dd > state.max_drawdown) state.max_drawdown = dd;
     }
-    
-    state.equity_history.push_back(state.equity);
-    if (state.equity_history.size() > 5000)
-    {
-        state.equity_history.erase(state.equity_history.begin());
-    }
 }
 
-void TradingEngine::ExecuteFill(bool is_buy, double price, double amount, bool reduce_only, int order_type)
+void TradingEngine::ExecuteFill(bool is_buy, Notional notional, Qty amount, bool reduce_only, int order_type, int64_t submit_ns, double time)
 {
-    PositionInfo* target_pos = nullptr;
-    double qty = 0.0;
-    bool is_opening = !reduce_only;
+    if (amount <= 0) return;
+    if (journal) journal->Append(EVT_FILL, JournalFlagsFor(is_buy, reduce_only), notional, amount, 0, (uint8_t)order_type);
 
-    if (is_buy)
+    if (order_type >= 0 && order_type < ORDER_TYPE_COUNT)
     {
-        if (!reduce_only)
-        {
-            target_pos = &state.long_pos;
-            qty = amount;
-        } else
-        {
-            target_pos = &state.short_pos;
-            qty = amount; 
-        }
-    } else
-    {
-        if (!reduce_only)
-        {
-            target_pos = &state.short_pos;
-            qty = -amount;
-        } else
-        {
-            target_pos = &state.long_pos;
-            qty = -amount; 
-        }
+        fill_latency[order_type].Record(MonotonicNanos() - submit_ns);
+        latency_dirty = true;
     }
 
-    if (!target_pos) return;
+    // Buys open longs and reduce shorts, sells open shorts and reduce longs.
+    PositionInfo* target_pos = (is_buy != reduce_only) ? &state.long_pos : &state.short_pos;
 
-    if (is_opening)
+    if (!reduce_only)
     {
-        double old_val = std::abs(target_pos->amount) * target_pos->entry_price;
-        double new_val = std::abs(qty) * price;
-        double new_amt = std::abs(target_pos->amount) + std::abs(qty);
-        
-        if (new_amt > 0)
-        {
-            target_pos->entry_price = (old_val + new_val) / new_amt;
-        } else
-        {
-            target_pos->entry_price = price;
-        }
-        target_pos->amount += qty;
-
+        target_pos->entry_cost += notional;
+        target_pos->amount += is_buy ? amount : -amount;
     } else
     {
-        double current_amt = target_pos->amount;
-        double close_qty = qty;
+        Qty held = std::abs(target_pos->amount);
+        Qty close_qty = std::min(amount, held);
 
-        if (is_buy)
+        if (close_qty > 0)
         {
-             if ((current_amt + close_qty) > 0.0) close_qty = -current_amt;
-        } else
-        {
-             if ((current_amt + close_qty) < 0.0) close_qty = -current_amt;
-        }
+            Notional released_cost = MulDiv(target_pos->entry_cost, close_qty, held);
+            Notional exit_value = MulDiv(notional, close_qty, amount);
+            Notional realized = (target_pos == &state.long_pos) ? exit_value - released_cost : released_cost - exit_value;
 
-        double realized = 0.0;
-        if (target_pos == &state.long_pos)
-        {
-            realized = (price - target_pos->entry_price) * std::abs(close_qty);
-        } else
-        {
-            realized = (target_pos->entry_price - price) * std::abs(close_qty);
-        }
-        
-        state.balance += realized;
-        target_pos->amount += close_qty;
+            state.balance += realized;
+            target_pos->entry_cost -= released_cost;
+            target_pos->amount += is_buy ? close_qty : -close_qty;
 
-        if (std::abs(close_qty) > 0.000001)
-        {
-             state.total_trades_count++;
-             if (realized > 0)
-             {
-                 state.winning_trades++;
-                 state.gross_profit += realized;
-             } else
-             {
-                state.gross_loss += std::abs(realized);
-             }
+            state.total_trades_count++;
+            if (realized > 0)
+            {
+                state.winning_trades++;
+                state.gross_profit += realized;
+            } else if (realized < 0)
+            {
+                state.losing_trades++;
+                state.gross_loss -= realized;
+            }
         }
     }
     
-    if (std::abs(target_pos->amount) < 0.000001)
+    if (target_pos->amount == 0)
     {
-        target_pos->amount = 0;
-        target_pos->entry_price = 0;
+        target_pos->entry_cost = 0;
     }
 
-    double current_time = state.candles.empty() ? 0.0 : state.candles.back().time;
-    state.order_history.insert(state.order_history.begin(), {0, is_buy, price, amount, order_type, current_time, reduce_only});
-    if (state.order_history.size() > 50) state.order_history.pop_back();
-    
-    UpdateAccount();
+    Price avg_price = (notional + amount / 2) / amount;
+    state.order_history.PushBack({0, is_buy, avg_price, amount, order_type, time, reduce_only, submit_ns});
 }
 
-void TradingEngine::PlaceOrder(bool is_buy, int order_type, double price, double amount, bool reduce_only)
+void TradingEngine::PlaceOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only, int64_t submit_ns)
 {
+    if (amount <= 0) return;
+    if (journal) journal->Append(EVT_PLACE_ORDER, JournalFlagsFor(is_buy, reduce_only), price, amount, 0, (uint8_t)order_type);
+
+    int64_t accept_ns = MonotonicNanos();
+    if (submit_ns <= 0) submit_ns = accept_ns;
+    if (order_type >= 0 && order_type < ORDER_TYPE_COUNT)
+    {
+        accept_latency[order_type].Record(accept_ns - submit_ns);
+        latency_dirty = true;
+    }
+
+    if (order_gateway)
+    {
+        RouteOrder(is_buy, order_type, price, amount, reduce_only, submit_ns);
+        return;
+    }
+
+    // A reduce-only order never takes more from the book than the position it closes.
+    if (reduce_only)
+    {
+        Qty held = is_buy ? -state.short_pos.amount : state.long_pos.amount;
+        amount = std::min(amount, held);
+        if (amount <= 0) return;
+    }
+
+    double current_time = market_time;
+    Notional notional = 0;
+    Qty filled = 0;
     if (order_type == ORDER_MARKET)
     {
-        double fill_p = is_buy ? state.asks[0].price : state.bids[0].price;
-        ExecuteFill(is_buy, fill_p, amount, reduce_only, ORDER_MARKET);
+        Price limit = is_buy ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::lowest();
+        filled = MatchAgainstBook(is_buy, limit, amount, notional, true);
+        ExecuteFill(is_buy, notional, filled, reduce_only, ORDER_MARKET, submit_ns, current_time);
     } 
     else if (order_type == ORDER_LIMIT)
     {
-        double current_time = state.candles.empty() ? 0.0 : state.candles.back().time;
-        state.open_orders.push_back({state.order_id_counter++, is_buy, price, amount, ORDER_LIMIT, current_time, reduce_only});
+        filled = MatchAgainstBook(is_buy, price, amount, notional, true);
+        ExecuteFill(is_buy, notional, filled, reduce_only, ORDER_LIMIT, submit_ns, current_time);
+
+        Qty remaining = amount - filled;
+        if (remaining > 0)
+        {
+            int id = state.order_id_counter++;
+            book.Add(id, is_buy, price, remaining, true);
+            open_order_slots[id] = state.open_orders.size();
+            state.open_orders.push_back({id, is_buy, price, remaining, ORDER_LIMIT, current_time, reduce_only, submit_ns});
+        }
     }
     else if (order_type == ORDER_FOK)
     {
-        auto& book = is_buy ? state.asks : state.bids;
-        double filled_vol = 0.0;
-        double weighted_price_sum = 0.0;
-        bool possible = false;
-        
-        for (const auto& level : book)
+        if (book.AvailableVolume(is_buy, price, amount, true) >= amount)
         {
-            if (is_buy)
-            {
-                if (level.price > price) break; 
-            } else
-            {
-                if (level.price < price) break; 
-            }
-            
-            double take = std::min(amount - filled_vol, level.volume);
-            weighted_price_sum += take * level.price;
-            filled_vol += take;
-            
-            if (filled_vol >= amount - 0.000001)
-            {
-                possible = true;
-                break;
-            }
-        }
-        
-        if (possible)
-        {
-            double avg_price = weighted_price_sum / amount;
-            ExecuteFill(is_buy, avg_price, amount, reduce_only, ORDER_FOK);
+            filled = MatchAgainstBook(is_buy, price, amount, notional, true);
+            ExecuteFill(is_buy, notional, filled, reduce_only, ORDER_FOK, submit_ns, current_time);
         } else
         {
-            std::cout << "FOK Order Killed" << std::endl;
+            state.killed_orders++;
         }
     }
+
+    bool any_fill = filled > 0 || !maker_fills.empty();
+    CheckLimitOrders(current_time);
+    if (any_fill) UpdateAccount();
+    book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+}
+
+bool TradingEngine::CancelOrder(int order_id)
+{
+    auto it = open_order_slots.find(order_id);
+    if (it == open_order_slots.end()) return false;
+    if (journal) journal->Append(EVT_CANCEL_ORDER, 0, 0, 0, order_id);
+    if (order_gateway) return RouteCancel(it->second);
+
+    book.Cancel(order_id);
+    RemoveOpenOrder(it->second);
+    book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+    return true;
+}
+
+bool TradingEngine::ModifyOrder(int order_id, Qty new_amount)
+{
+    if (new_amount <= 0) return CancelOrder(order_id);
+    auto it = open_order_slots.find(order_id);
+    if (it == open_order_slots.end()) return false;
+    if (journal) journal->Append(EVT_MODIFY_ORDER, 0, 0, new_amount, order_id);
+
+    if (order_gateway)
+    {
+        // The open amount changes when the external engine confirms it.
+        const MyOrder& order = state.open_orders[it->second];
+        return order_gateway->Send({MonotonicNanos(), order_id, ORDER_ACTION_MODIFY, (uint8_t)order.order_type,
+            order.is_buy, order.reduce_only, order.price, new_amount});
+    }
+
+    book.Modify(order_id, new_amount);
+    state.open_orders[it->second].amount = new_amount;
+    book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+    return true;
+}
+
+const MyOrder* TradingEngine::FindOrder(int order_id) const
+{
+    auto it = open_order_slots.find(order_id);
+    return (it != open_order_slots.end()) ? &state.open_orders[it->second] : nullptr;
 }
 
-void TradingEngine::CancelOrder(int index)
+int TradingEngine::CancelAllOrders()
 {
-    if (index >= 0 && index < (int)state.open_orders.size())
+    if (journal) journal->Append(EVT_CANCEL_ALL, 0, 0, 0);
+    if (order_gateway) return RouteCancels(true, false, 0, 0);
+
+    int count = (int)state.open_orders.size();
+    for (const auto& order : state.open_orders) book.Cancel(order.id);
+
+    state.open_orders.clear();
+    open_order_slots.clear();
+    if (count > 0) book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+    return count;
+}
+
+int TradingEngine::CancelOrders(bool is_buy)
+{
+    return CancelOrders(is_buy, -std::numeric_limits<Price>::max(), std::numeric_limits<Price>::max());
+}
+
+int TradingEngine::CancelOrders(bool is_buy, Price low, Price high)
+{
+    if (journal) journal->Append(EVT_CANCEL_RANGE, JournalFlagsFor(is_buy, false), low, high);
+    if (order_gateway) return RouteCancels(false, is_buy, low, high);
+
+    cancel_ids.clear();
+    book.CollectUserOrders(is_buy, low, high, cancel_ids);
+
+    for (int64_t id : cancel_ids)
     {
-        state.open_orders.erase(state.open_orders.begin() + index);
+        book.Cancel(id);
+        auto it = open_order_slots.find((int)id);
+        if (it != open_order_slots.end()) RemoveOpenOrder(it->second);
     }
+
+    if (!cancel_ids.empty()) book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+    return (int)cancel_ids.size();
+}
+
+void TradingEngine::RemoveOpenOrder(size_t slot)
+{
+    open_order_slots.erase(state.open_orders[slot].id);
+
+    if (slot + 1 != state.open_orders.size())
+    {
+        state.open_orders[slot] = state.open_orders.back();
+        open_order_slots[state.open_orders[slot].id] = slot;
+    }
+    state.open_orders.pop_back();
+}
+
+void TradingEngine::RouteOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only, int64_t submit_ns)
+{
+    int id = state.order_id_counter++;
+    OrderRequest request = {submit_ns, id, ORDER_ACTION_NEW, (uint8_t)order_type, is_buy, reduce_only, price, amount};
+    // A full queue refuses the order; the gateway counts it.
+    if (!order_gateway->Send(request)) return;
+
+    double current_time = market_time;
+    MyOrder order = {id, is_buy, price, amount, order_type, current_time, reduce_only, submit_ns};
+    routed_orders.emplace(id, order);
+    open_order_slots[id] = state.open_orders.size();
+    state.open_orders.push_back(order);
+}
+
+bool TradingEngine::RouteCancel(size_t slot)
+{
+    const MyOrder& order = state.open_orders[slot];
+    OrderRequest request = {MonotonicNanos(), order.id, ORDER_ACTION_CANCEL, (uint8_t)order.order_type,
+        order.is_buy, order.reduce_only, order.price, 0};
+    if (!order_gateway->Send(request)) return false;
+    RemoveOpenOrder(slot);
+    return true;
+}
+
+int TradingEngine::RouteCancels(bool all, bool is_buy, Price low, Price high)
+{
+    int count = 0;
+    for (size_t slot = state.open_orders.size(); slot-- > 0;)
+    {
+        const MyOrder& order = state.open_orders[slot];
+        bool selected = all || (order.is_buy == is_buy && order.price >= low && order.price <= high);
+        if (selected && RouteCancel(slot)) count++;
+    }
+    return count;
+}
+
+void TradingEngine::SetOrderGateway(OrderGateway* gateway)
+{
+    order_gateway = gateway;
+}
+
+void TradingEngine::ApplyExecution(const ExecutionReport& report)
+{
+    auto it = routed_orders.find(report.order_id);
+    if (it == routed_orders.end()) return;
+
+    const MyOrder& order = it->second;
+    if (report.status == EXEC_FILL)
+    {
+        ExecuteFill(order.is_buy, report.price * report.amount, report.amount, order.reduce_only, order.order_type, order.submit_ns, market_time);
+    }
+
+    bool done = report.status == EXEC_CANCELED || report.status == EXEC_REJECTED || report.leaves <= 0;
+    auto slot = open_order_slots.find(report.order_id);
+    if (slot != open_order_slots.end())
+    {
+        if (done) RemoveOpenOrder(slot->second);
+        else state.open_orders[slot->second].amount = report.leaves;
+    }
+    if (done) routed_orders.erase(it);
+}
+
+void TradingEngine::SummarizeLatency()
+{
+    if (!latency_dirty) return;
+    for (int type = 0; type < ORDER_TYPE_COUNT; ++type)
+    {
+        accept_latency[type].Summarize(state.accept_latency[type]);
+        fill_latency[type].Summarize(state.fill_latency[type]);
+    }
+    latency_dirty = false;
 }
 
 void TradingEngine::ClosePosition(bool close_long, bool close_short)
 {
-    if (close_long && state.long_pos.amount > 0.0)
+    if (close_long && state.long_pos.amount > 0)
     {
         PlaceOrder(false, ORDER_MARKET, 0, state.long_pos.amount, true); 
     }
-    if (close_short && state.short_pos.amount < 0.0)
+    if (close_short && state.short_pos.amount < 0)
     {
-        PlaceOrder(true, ORDER_MARKET, 0, std::abs(state.short_pos.amount), true); 
+        PlaceOrder(true, ORDER_MARKET, 0, -state.short_pos.amount, true); 
     }
-    TradingEngine::UpdateAccount();
 }
 
-void TradingEngine::CheckLimitOrders()
+void TradingEngine::SetPaused(bool paused)
 {
-    for (auto it = state.open_orders.begin(); it != state.open_orders.end();)
+    if (journal) journal->Append(EVT_SET_PAUSED, 0, paused ? 1 : 0, 0);
+    state.is_paused = paused;
+}
+
+void TradingEngine::SetSimulationInterval(double interval_s)
+{
+    if (journal) journal->Append(EVT_SET_INTERVAL, 0, DoubleBits(interval_s), 0);
+    state.simulation_update_interval_s = interval_s;
+}
+
+void TradingEngine::SetTicksPerCandle(int ticks)
+{
+    if (journal) journal->Append(EVT_SET_TICKS, 0, ticks, 0);
+    state.ticks_per_candle = std::max(ticks, 0);
+}
+
+void TradingEngine::SetMarketDataSource(MarketDataSource* source)
+{
+    market_source = source;
+}
+
+void TradingEngine::ApplyCandle(const Candle& candle)
+{
+    PullSyntheticBook();
+    AppendCandle(candle);
+    state.current_price = candle.close;
+
+    Notional notional = 0;
+    MatchAgainstBook(true, candle.close, std::numeric_limits<Qty>::max(), notional);
+    MatchAgainstBook(false, candle.close, std::numeric_limits<Qty>::max(), notional);
+}
+
+void TradingEngine::ApplyTrade(const Trade& trade)
+{
+    // Positions are marked at every trade, not only at candle closes.
+    state.current_price = trade.price;
+    AdvanceMarketTime(trade.time);
+    MarkToMarket();
+
+    Notional notional = 0;
+    MatchAgainstBook(trade.is_buy, trade.price, trade.amount, notional);
+    state.trade_history.PushBack(trade);
+}
+
+void TradingEngine::ApplyBookUpdate(bool is_bid, Price price, Qty volume)
+{
+    auto& levels = is_bid ? feed_bids : feed_asks;
+    auto it = levels.find(price);
+    if (it != levels.end())
     {
-        bool hit = false;
-        if (it->is_buy && state.current_price <= it->price) hit = true;
-        else if (!it->is_buy && state.current_price >= it->price) hit = true;
-        
-        if (hit)
-        {
-            ExecuteFill(it->is_buy, it->price, it->amount, it->reduce_only, ORDER_LIMIT);
-            it = state.open_orders.erase(it);
-        } else
-        {
-            ++it;
-        }
+        // Modify fails if trades already consumed the level; it is then re-added below.
+        if (volume > 0 && book.Modify(it->second, volume)) return;
+        book.Cancel(it->second);
+        levels.erase(it);
     }
+    if (volume <= 0) return;
+
+    book.Add(synthetic_id_counter, is_bid, price, volume, false);
+    levels.emplace(price, synthetic_id_counter++);
 }
 
-void TradingEngine::GenerateMarketData()
+void TradingEngine::ClearFeedBook()
 {
-    std::normal_distribution<double> walk(0.0, 30.0);
-    std::uniform_real_distribution<double> noise(0.0, 10.0);
-    std::uniform_real_distribution<double> vol_dist(0.5, 10.0);
+    for (const auto& level : feed_bids) book.Cancel(level.second);
+    for (const auto& level : feed_asks) book.Cancel(level.second);
+    feed_bids.clear();
+    feed_asks.clear();
+}
 
-    double move = walk(state.rng);
-    double prev_close = state.candles.back().close;
-    double new_open = prev_close;
-    double new_close = new_open + move;
-    double new_high = std::max(new_open, new_close) + noise(state.rng);
-    double new_low = std::min(new_open, new_close) - noise(state.rng);
-    double new_time = state.candles.back().time + 60.0;
+void TradingEngine::SetCandleArchive(CandleStoreWriter* archive)
+{
+    candle_archive = archive;
+}
 
-    state.candles.push_back({new_time, new_open, new_high, new_low, new_close, vol_dist(state.rng)});
-    state.current_price = new_close;
+void TradingEngine::SetJournal(JournalWriter* writer)
+{
+    journal = writer;
+}
+
+void TradingEngine::CheckLimitOrders(double time)
+{
+    for (const auto& fill : maker_fills)
+    {
+        auto it = open_order_slots.find((int)fill.maker_id);
+        if (it == open_order_slots.end()) continue;
+
+        size_t slot = it->second;
+        MyOrder& order = state.open_orders[slot];
+        ExecuteFill(order.is_buy, fill.price * fill.amount, fill.amount, order.reduce_only, ORDER_LIMIT, order.submit_ns, time);
+        order.amount -= fill.amount;
+        if (order.amount <= 0) RemoveOpenOrder(slot);
+    }
+    maker_fills.clear();
+}
 
-    if (state.candles.size() > 2000) state.candles.erase(state.candles.begin());
+Qty TradingEngine::MatchAgainstBook(bool is_buy, Price limit_price, Qty amount, Notional& notional, bool user_taker)
+{
+    fills.clear();
+    self_cancels.clear();
+    Qty filled = book.Match(is_buy, limit_price, amount, fills, user_taker ? &self_cancels : nullptr);
 
-    state.bids.clear();
-    state.asks.clear();
-    
-    double p = state.current_price;
+    for (int64_t id : self_cancels)
+    {
+        auto it = open_order_slots.find((int)id);
+        if (it != open_order_slots.end()) RemoveOpenOrder(it->second);
+    }
+
+    notional = 0;
+    for (const auto& fill : fills)
+    {
+        notional += fill.price * fill.amount;
+        if (fill.maker_is_user) maker_fills.push_back(fill);
+    }
+    return filled;
+}
+
+void TradingEngine::QuoteSyntheticBook()
+{
+    const Instrument& inst = state.instrument;
+    Price p = state.current_price;
 
-    for(int i=0; i<15; ++i)
+    for(int i=0; i<BOOK_DEPTH; ++i)
     {
-        p -= std::uniform_real_distribution<double>(1.0, 5.0)(state.rng);
-        state.bids.push_back({p, std::uniform_real_distribution<double>(0.1, 5.0)(state.rng), true});
+        p -= inst.ToTicks(std::uniform_real_distribution<double>(1.0, 5.0)(rng));
+        book.Add(synthetic_id_counter, true, p, inst.ToLots(std::uniform_real_distribution<double>(0.1, 5.0)(rng)), false);
+        synthetic_ids.push_back(synthetic_id_counter++);
     }
     p = state.current_price;
 
-    for(int i=0; i<15; ++i)
+    for(int i=0; i<BOOK_DEPTH; ++i)
     {
-        p += std::uniform_real_distribution<double>(1.0, 5.0)(state.rng);
-        state.asks.push_back({p, std::uniform_real_distribution<double>(0.1, 5.0)(state.rng), false});
+        p += inst.ToTicks(std::uniform_real_distribution<double>(1.0, 5.0)(rng));
+        book.Add(synthetic_id_counter, false, p, inst.ToLots(std::uniform_real_distribution<double>(0.1, 5.0)(rng)), false);
+        synthetic_ids.push_back(synthetic_id_counter++);
     }
+}
+
+void TradingEngine::PullSyntheticBook()
+{
+    for (int64_t id : synthetic_ids) book.Cancel(id);
+    synthetic_ids.clear();
+}
 
-    if (std::uniform_real_distribution<double>(0.0, 1.0)(state.rng) > 0.3)
+void TradingEngine::RecordTrade(double time, Notional notional, Qty amount, bool is_buy)
+{
+    AdvanceMarketTime(time);
+    state.trade_history.PushBack({time, (notional + amount / 2) / amount, amount, is_buy});
+}
+
+void TradingEngine::GenerateCandle(double time)
+{
+    std::normal_distribution<double> walk(0.0, market_model.step_sigma);
+    std::uniform_real_distribution<double> noise(0.0, market_model.wick_max);
+    std::uniform_real_distribution<double> vol_dist(market_model.volume_min, market_model.volume_max);
+
+    const Instrument& inst = state.instrument;
+    Price move = inst.ToTicks(walk(rng));
+    Price prev_close = state.candles.Back().close;
+    Price new_open = prev_close;
+    Price new_close = new_open + move;
+    Price new_high = std::max(new_open, new_close) + inst.ToTicks(noise(rng));
+    Price new_low = std::min(new_open, new_close) - inst.ToTicks(noise(rng));
+
+    AppendCandle({time, new_open, new_high, new_low, new_close, inst.ToLots(vol_dist(rng))});
+    state.current_price = new_close;
+
+    PullSyntheticBook();
+
+    // The market trades through the new price, filling any resting orders it crosses.
+    Notional notional = 0;
+    Qty swept = MatchAgainstBook(true, new_close, std::numeric_limits<Qty>::max(), notional);
+    if (swept > 0) RecordTrade(time, notional, swept, true);
+    swept = MatchAgainstBook(false, new_close, std::numeric_limits<Qty>::max(), notional);
+    if (swept > 0) RecordTrade(time, notional, swept, false);
+}
+
+void TradingEngine::GenerateTicks(double time)
+{
+    // The synthetic depth is pulled for the minute, so ticks trade against user orders only;
+    // QuoteSyntheticBook re-quotes it around the close afterwards.
+    PullSyntheticBook();
+
+    const Instrument& inst = state.instrument;
+    int n = state.ticks_per_candle;
+    std::normal_distribution<double> walk(0.0, market_model.step_sigma / std::sqrt((double)n));
+    std::uniform_real_distribution<double> size(market_model.volume_min / n, market_model.volume_max / n);
+    double tick_seconds = 60.0 / n;
+
+    Price open = state.candles.Back().close;
+    Price price = open, high = open, low = open;
+    Qty volume = 0;
+    bool is_buy = true;
+    Notional notional = 0;
+    for (int i = 0; i < n; ++i)
     {
-        bool is_buy = std::uniform_int_distribution<int>(0, 1)(state.rng);
-        state.trade_history.insert(state.trade_history.begin(),
+        Price move = inst.ToTicks(walk(rng));
+        price += move;
+        if (move != 0) is_buy = move > 0;
+        Qty amount = std::max<Qty>(1, inst.ToLots(size(rng)));
+        high = std::max(high, price);
+        low = std::min(low, price);
+        volume += amount;
+        double tick_time = time + i * tick_seconds;
+        AdvanceMarketTime(tick_time);
+        state.trade_history.PushBack({tick_time, price, amount, is_buy});
+
+        // Resting user orders this print trades through fill now, at their own price.
+        bool crosses_ask = book.HasAsks() && book.BestAsk() <= price;
+        bool crosses_bid = book.HasBids() && book.BestBid() >= price;
+        if (crosses_ask || crosses_bid)
+        {
+            state.current_price = price;
+            if (crosses_ask) MatchAgainstBook(true, price, std::numeric_limits<Qty>::max(), notional);
+            if (crosses_bid) MatchAgainstBook(false, price, std::numeric_limits<Qty>::max(), notional);
+            // Also counted in GenerateMarketData's time, which encloses it.
+            PROFILE_SCOPE(PROF_CHECK_LIMIT_ORDERS);
+            CheckLimitOrders(market_time);
+        }
+    }
+
+    AppendCandle({time, open, high, low, price, volume});
+    state.current_price = price;
+}
+
+void TradingEngine::GenerateMarketData()
+{
+    PROFILE_SCOPE(PROF_GENERATE_MARKET_DATA);
+    const Instrument& inst = state.instrument;
+    double new_time = state.candles.Back().time + 60.0;
+
+    if (state.ticks_per_candle > 0) GenerateTicks(new_time);
+    else GenerateCandle(new_time);
+
+    QuoteSyntheticBook();
+
+    Notional notional = 0;
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) > 0.3)
     {
-            new_time, 
-            state.current_price + (is_buy ? 1.0 : -1.0), 
-            std::uniform_real_distribution<double>(0.01, 2.0)(state.rng), 
-            is_buy
-        });
-        if (state.trade_history.size() > 50) state.trade_history.pop_back();
+        bool is_buy = std::uniform_int_distribution<int>(0, 1)(rng);
+        Qty amount = inst.ToLots(std::uniform_real_distribution<double>(0.01, 2.0)(rng));
+        Price limit = is_buy ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::lowest();
+        Qty filled = MatchAgainstBook(is_buy, limit, amount, notional);
+        if (filled > 0) RecordTrade(new_time, notional, filled, is_buy);
     }
+
+    book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+}
+
+bool TradingEngine::Update(double dt)
+{
+    if (state.is_paused) return false;
+
+    update_accumulator += dt;
+    if (update_accumulator < state.simulation_update_interval_s) return false;
+    update_accumulator = 0.0;
+
+    // Only ticks are timed; the early returns above would just dilute the figures.
+    PROFILE_SCOPE(PROF_ENGINE_UPDATE);
+    return Step();
 }
 
-void TradingEngine::Update(double dt)
+double TradingEngine::TimeToNextUpdate() const
 {
-    if (state.is_paused) return;
+    if (state.is_paused) return std::numeric_limits<double>::infinity();
+    return std::max(0.0, state.simulation_update_interval_s - update_accumulator);
+}
 
-    static double accumulator = 0.0;
-    accumulator += dt;
-    if (accumulator < state.simulation_update_interval_s) return;
-    accumulator = 0.0;
+bool TradingEngine::Step()
+{
+    PROFILE_TICK();
+    if (market_source)
+    {
+        if (!market_source->Advance(*this)) return false;
+        book.GetDepth(BOOK_DEPTH, state.bids, state.asks);
+    } else
+    {
+        GenerateMarketData();
+    }
+
+    // Timed here rather than inside, so order placement does not pay for the timers.
+    {
+        PROFILE_SCOPE(PROF_CHECK_LIMIT_ORDERS);
+        CheckLimitOrders(market_time);
+    }
+    {
+        PROFILE_SCOPE(PROF_UPDATE_ACCOUNT);
+        UpdateAccount();
+        if (state.candles.TotalPushed() != sampled_candles)
+        {
+            sampled_candles = state.candles.TotalPushed();
+            performance.AddEquity(state.instrument.ToValue(state.equity));
+        }
+        performance.Summarize(state, state.performance);
+    }
 
-    GenerateMarketData();
-    CheckLimitOrders();
-    UpdateAccount();
+    if (journal) journal->Append(EVT_TICK, 0, state.current_price, (int64_t)state.candles.TotalPushed());
+    return true;
 }
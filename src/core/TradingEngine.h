@@ -1,7 +1,19 @@
 #pragma once
 #include "Models.h"
+#include "OrderBook.h"
+#include "LatencyHistogram.h"
+#include "PerformanceStats.h"
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <random>
+#include <unordered_map>
+
+class JournalWriter;
+class MarketDataSource;
+class OrderGateway;
+struct ExecutionReport;
+class CandleStoreWriter;
 
 class TradingEngine
 {
@@ -10,17 +22,129 @@ public:
 
     TradingEngine();
     void Init();
-    void Update(double dt);
+    void Init(uint32_t seed);
+    void Init(uint32_t seed, double now);
+    bool Update(double dt);
+    // Seconds until Update next steps the engine; infinity while paused.
+    double TimeToNextUpdate() const;
+    // Returns false once an attached market data source is exhausted.
+    bool Step();
     
-    void PlaceOrder(bool is_buy, int order_type, double price, double amount, bool reduce_only = false);
-    void CancelOrder(int index);
+    // submit_ns is the MonotonicNanos() stamp of the order's submission; 0 means now.
+    void PlaceOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only = false, int64_t submit_ns = 0);
+    bool CancelOrder(int order_id);
+    // Changes the resting amount; a smaller amount keeps queue priority, zero cancels.
+    bool ModifyOrder(int order_id, Qty new_amount);
+    const MyOrder* FindOrder(int order_id) const;
+
+    // Bulk cancels return the number of orders removed and cost O(log n + removed).
+    int CancelAllOrders();
+    int CancelOrders(bool is_buy);
+    int CancelOrders(bool is_buy, Price low, Price high);
+
     void ClosePosition(bool close_long, bool close_short);
+    void SetPaused(bool paused);
+    void SetSimulationInterval(double interval_s);
+    // Simulates each 1m candle as this many trades, filling resting orders at every
+    // trade they are crossed by; 0 generates whole candles filled at the close.
+    void SetTicksPerCandle(int ticks);
+
+    // Source of market data for Step() (not owned); nullptr uses the built-in random walk.
+    // Attach before Init, which then starts from an empty history.
+    void SetMarketDataSource(MarketDataSource* source);
+
+    // Market-side inputs for data sources. A candle fills resting user orders it trades
+    // through, a trade matches against the book, a book update sets external volume at a level.
+    void ApplyCandle(const Candle& candle);
+    void ApplyTrade(const Trade& trade);
+    void ApplyBookUpdate(bool is_bid, Price price, Qty volume);
+    // Quotes a fixed number of random levels a side around current_price, for sources that carry
+    // no depth of their own. The next candle pulls them before it trades through the book.
+    void QuoteSyntheticBook();
+    // Removes every level set by ApplyBookUpdate, before a feed applies a fresh snapshot.
+    void ClearFeedBook();
+
+    // Sends user orders, cancels and modifies to an external engine (not owned) instead of
+    // matching them in the local book; nullptr matches locally. Cancelled orders leave
+    // open_orders at once, but fills reported before the cancel is confirmed still apply.
+    void SetOrderGateway(OrderGateway* gateway);
+    // Applies the external engine's report on a routed order.
+    void ApplyExecution(const ExecutionReport& report);
+
+    // Every 1m candle is also appended to the archive (not owned); nullptr detaches it.
+    void SetCandleArchive(CandleStoreWriter* archive);
+
+    // Every input event is appended to the journal (not owned) until it is detached with nullptr.
+    void SetJournal(JournalWriter* writer);
+
+    static const CandleSeries& GetCandles(const TradingState& state, int timeframe_idx);
 
-    std::vector<Candle> GetCandles(int timeframe_idx) const;
+    // Copies the order latency percentiles into state.accept_latency / fill_latency.
+    // A no-op unless an order was accepted or filled since the last call.
+    void SummarizeLatency();
 
 private:
+    friend class EngineBench;
+
+    std::mt19937 rng;
+    MarketModel market_model;
+    double update_accumulator = 0.0;
+    // Time of the latest candle or trade, never decreasing. Orders and fills are stamped
+    // with it, so order_history stays in time order for the chart's binary search.
+    double market_time = 0.0;
+    JournalWriter* journal = nullptr;
+    MarketDataSource* market_source = nullptr;
+    OrderGateway* order_gateway = nullptr;
+    CandleStoreWriter* candle_archive = nullptr;
+
+    OrderBook book;
+    std::vector<BookFill> fills;
+    std::vector<BookFill> maker_fills;
+    std::vector<int64_t> synthetic_ids;
+    int64_t synthetic_id_counter = 0;
+
+    LatencyHistogram accept_latency[ORDER_TYPE_COUNT];
+    LatencyHistogram fill_latency[ORDER_TYPE_COUNT];
+    bool latency_dirty = false;
+
+    // Sampled once per new 1m candle, at the end of Step.
+    PerformanceTracker performance;
+    uint64_t sampled_candles = 0;
+
+    // Order id -> position in state.open_orders.
+    std::unordered_map<int, size_t> open_order_slots;
+    std::vector<int64_t> cancel_ids;
+    std::vector<int64_t> self_cancels;
+
+    // Orders live at the external engine, until it reports them done.
+    std::unordered_map<int, MyOrder> routed_orders;
+
+    // External book levels from a data source: price -> book order id.
+    std::unordered_map<Price, int64_t> feed_bids;
+    std::unordered_map<Price, int64_t> feed_asks;
+
+    // Marks positions at current_price, then records an equity sample.
     void UpdateAccount();
-    void ExecuteFill(bool is_buy, double price, double amount, bool reduce_only, int order_type);
-    void CheckLimitOrders();
+    void MarkToMarket();
+    // Applies a fill to positions and balance, stamped with the market time it traded at;
+    // callers run UpdateAccount once per batch of fills.
+    void ExecuteFill(bool is_buy, Notional notional, Qty amount, bool reduce_only, int order_type, int64_t submit_ns, double time);
+    // User orders rest in the book's price-sorted levels, so a price move only reaches the
+    // levels it crosses. This settles the resulting maker fills: O(crossed), not O(resting).
+    void CheckLimitOrders(double time);
+    void RemoveOpenOrder(size_t slot);
+    void RouteOrder(bool is_buy, int order_type, Price price, Qty amount, bool reduce_only, int64_t submit_ns);
+    bool RouteCancel(size_t slot);
+    // Cancels the open orders on one side within [low, high], or every open order if all.
+    int RouteCancels(bool all, bool is_buy, Price low, Price high);
     void GenerateMarketData();
+    void GenerateCandle(double time);
+    void GenerateTicks(double time);
+    void AppendCandle(const Candle& candle);
+    void AdvanceMarketTime(double time) { market_time = std::max(market_time, time); }
+
+    // User takers cancel the user's own resting orders they reach instead of trading with them.
+    Qty MatchAgainstBook(bool is_buy, Price limit_price, Qty amount, Notional& notional, bool user_taker = false);
+    void PullSyntheticBook();
+    void RecordTrade(double time, Notional notional, Qty amount, bool is_buy);
 };
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+
+// Single-writer / single-reader triple buffer. The writer fills WriteBuffer()
+// and calls Publish(); the reader calls Consume() and then reads ReadBuffer().
+// Neither side ever blocks and the reader always sees a complete snapshot.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& WriteBuffer() { return buffers[back]; }
+
+    void Publish()
+    {
+        back = middle.exchange(back | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    bool Consume()
+    {
+        if ((middle.load(std::memory_order_acquire) & DIRTY_BIT) == 0) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return buffers[front]; }
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int DIRTY_BIT = 0x4;
+
+    T buffers[3];
+    std::atomic<int> middle{1};
+    int back = 0;
+    int front = 2;
+};
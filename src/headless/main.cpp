@@ -0,0 +1,768 @@
+#include "core/TradingEngine.h"
+#include "core/CandleStore.h"
+#include "core/FeedHandler.h"
+#include "core/Journal.h"
+#include "core/MarketDataSource.h"
+#include "core/MonteCarlo.h"
+#include "core/ShmBridge.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct RunOptions
+    {
+        long long minutes = 100000;
+        uint32_t seed = 42;
+        bool quote = true;
+        int max_resting = 100;
+        int flatten_every = 60;
+        std::string journal_path;
+        std::string replay_path;
+        std::string market_path;
+        std::string export_path;
+        std::string archive_path;
+        double speed = 0.0;
+        int symbols = 1;
+        int threads = 0;
+        long long paths = 0;
+        int tick_sim = 0;
+        std::string feed;
+        std::string publish;
+        bool feed_loopback = false;
+        int feed_drop = 0;
+        double publish_rate = 0.0;
+        std::string bridge;
+        std::string serve_bridge;
+    };
+
+    constexpr const char* DEFAULT_FEED = "239.255.42.1:30001";
+
+    void PrintUsage(const char* exe)
+    {
+        std::printf("Usage: %s [options]\n", exe);
+        std::printf("  --minutes N        simulated 1m candles to run (default 100000)\n");
+        std::printf("  --ticks N          alias for --minutes\n");
+        std::printf("  --seed N           RNG seed for market and strategy (default 42)\n");
+        std::printf("  --no-quote         run the market only, without the quoting strategy\n");
+        std::printf("  --max-resting N    resting orders kept by the quoting strategy (default 100)\n");
+        std::printf("  --flatten-every N  close all positions every N minutes, 0 = never (default 60)\n");
+        std::printf("  --journal PATH     record every input event of the run to PATH\n");
+        std::printf("  --replay PATH      rebuild the state from a journal instead of running\n");
+        std::printf("  --market PATH      take market data from a recorded file instead of the random walk\n");
+        std::printf("  --speed N          pace --market at N x real time, 0 = unthrottled (default 0)\n");
+        std::printf("  --export-market P  record the run's candles, trades and book levels to P\n");
+        std::printf("  --archive PATH     append every 1m candle to the columnar store PATH.cdat/.cidx\n");
+        std::printf("  --symbols N        run N independent symbols, each for --minutes (default 1)\n");
+        std::printf("  --threads N        worker threads for --symbols and --paths, 0 = one per core (default 0)\n");
+        std::printf("  --paths N          Monte Carlo: run the strategy on N random paths of --minutes each\n");
+        std::printf("  --tick-sim N       simulate each minute as N trades, filling orders per trade (default 0 = whole candles)\n");
+        std::printf("  --feed G:P         take market data from the UDP feed on group G, port P (snapshots on TCP P+1)\n");
+        std::printf("  --publish G:P      publish the simulated market as a UDP feed on G:P for --minutes, then exit\n");
+        std::printf("  --feed-loopback    publish and consume a feed in one process (on --feed, default %s)\n", DEFAULT_FEED);
+        std::printf("  --feed-drop N      publisher skips every Nth packet, to exercise gap recovery\n");
+        std::printf("  --publish-rate N   candles published per second, 0 = unthrottled (default 0)\n");
+        std::printf("  --bridge NAME      trade against an external engine through shared memory segment NAME\n");
+        std::printf("  --serve-bridge N   stand-in external engine: create segment N and run the market for one dashboard\n");
+    }
+
+    bool ParseArgs(int argc, char** argv, RunOptions& opts)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            bool has_value = (i + 1 < argc);
+
+            if ((!std::strcmp(arg, "--minutes") || !std::strcmp(arg, "--ticks")) && has_value) opts.minutes = std::atoll(argv[++i]);
+            else if (!std::strcmp(arg, "--seed") && has_value) opts.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            else if (!std::strcmp(arg, "--no-quote")) opts.quote = false;
+            else if (!std::strcmp(arg, "--max-resting") && has_value) opts.max_resting = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--flatten-every") && has_value) opts.flatten_every = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--journal") && has_value) opts.journal_path = argv[++i];
+            else if (!std::strcmp(arg, "--replay") && has_value) opts.replay_path = argv[++i];
+            else if (!std::strcmp(arg, "--market") && has_value) opts.market_path = argv[++i];
+            else if (!std::strcmp(arg, "--speed") && has_value) opts.speed = std::atof(argv[++i]);
+            else if (!std::strcmp(arg, "--export-market") && has_value) opts.export_path = argv[++i];
+            else if (!std::strcmp(arg, "--archive") && has_value) opts.archive_path = argv[++i];
+            else if (!std::strcmp(arg, "--symbols") && has_value) opts.symbols = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--threads") && has_value) opts.threads = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--paths") && has_value) opts.paths = std::atoll(argv[++i]);
+            else if (!std::strcmp(arg, "--tick-sim") && has_value) opts.tick_sim = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--feed") && has_value) opts.feed = argv[++i];
+            else if (!std::strcmp(arg, "--publish") && has_value) opts.publish = argv[++i];
+            else if (!std::strcmp(arg, "--feed-loopback")) opts.feed_loopback = true;
+            else if (!std::strcmp(arg, "--feed-drop") && has_value) opts.feed_drop = std::atoi(argv[++i]);
+            else if (!std::strcmp(arg, "--publish-rate") && has_value) opts.publish_rate = std::atof(argv[++i]);
+            else if (!std::strcmp(arg, "--bridge") && has_value) opts.bridge = argv[++i];
+            else if (!std::strcmp(arg, "--serve-bridge") && has_value) opts.serve_bridge = argv[++i];
+            else return false;
+        }
+        if (opts.feed_loopback && opts.feed.empty()) opts.feed = DEFAULT_FEED;
+        return opts.minutes > 0 && opts.symbols > 0;
+    }
+
+    // "group:port" -> group and port; the snapshot channel is port + 1.
+    bool ParseFeed(const std::string& text, std::string& group, uint16_t& port)
+    {
+        size_t colon = text.rfind(':');
+        if (colon == std::string::npos) return false;
+        group = text.substr(0, colon);
+        int value = std::atoi(text.c_str() + colon + 1);
+        if (value <= 0 || value >= 65535) return false;
+        port = (uint16_t)value;
+        return true;
+    }
+
+    // Places one resting bid and ask around the last price every tick and
+    // cancels the oldest orders beyond max_resting, so the run exercises
+    // resting, matching and cancel paths as well as the market itself.
+    void QuoteAroundPrice(TradingEngine& engine, std::mt19937& rng, const RunOptions& opts)
+    {
+        const Instrument& inst = engine.state.instrument;
+        std::uniform_real_distribution<double> offset(1.0, 20.0);
+        std::uniform_real_distribution<double> size(0.05, 0.5);
+
+        Price p = engine.state.current_price;
+        engine.PlaceOrder(true, ORDER_LIMIT, p - inst.ToTicks(offset(rng)), inst.ToLots(size(rng)));
+        engine.PlaceOrder(false, ORDER_LIMIT, p + inst.ToTicks(offset(rng)), inst.ToLots(size(rng)));
+
+        // open_orders is unordered, so the oldest is the one with the lowest id.
+        const std::vector<MyOrder>& orders = engine.state.open_orders;
+        while ((int)orders.size() > opts.max_resting)
+        {
+            auto oldest = std::min_element(orders.begin(), orders.end(), [](const MyOrder& a, const MyOrder& b) { return a.id < b.id; });
+            if (!engine.CancelOrder(oldest->id)) break;
+        }
+    }
+
+    // Writes each tick's new trades, changed top-of-book levels and candle in replayable
+    // form, to a MarketDataWriter file or a FeedPublisher.
+    template <typename Writer>
+    class MarketExporter
+    {
+    public:
+        explicit MarketExporter(Writer& writer) : writer(writer) {}
+
+        void Capture(const TradingState& state)
+        {
+            Candle candle = state.candles.Back();
+            uint64_t new_trades = state.trade_history.TotalPushed() - trades_seen;
+            size_t available = state.trade_history.Size();
+            for (uint64_t i = (new_trades < available) ? available - new_trades : 0; i < available; ++i)
+            {
+                writer.WriteTrade(state.trade_history[i]);
+            }
+            trades_seen = state.trade_history.TotalPushed();
+
+            WriteLevels(candle.time, true, state.bids, last_bids);
+            WriteLevels(candle.time, false, state.asks, last_asks);
+            writer.WriteCandle(candle);
+        }
+
+    private:
+        Writer& writer;
+        uint64_t trades_seen = 0;
+        std::vector<OrderBookEntry> last_bids;
+        std::vector<OrderBookEntry> last_asks;
+
+        void WriteLevels(double time, bool is_bid, const std::vector<OrderBookEntry>& levels, std::vector<OrderBookEntry>& last)
+        {
+            for (const auto& old_level : last)
+            {
+                bool still_there = false;
+                for (const auto& level : levels) still_there = still_there || level.price == old_level.price;
+                if (!still_there) writer.WriteBook(time, is_bid, old_level.price, 0);
+            }
+            for (const auto& level : levels) writer.WriteBook(time, is_bid, level.price, level.volume);
+            last = levels;
+        }
+    };
+
+    // Reopens the archive and times a one-day range query at its end.
+    void PrintArchive(const std::string& path)
+    {
+        CandleStore store;
+        if (!store.Open(path))
+        {
+            std::printf("archive           : cannot open %s\n", path.c_str());
+            return;
+        }
+
+        std::vector<Candle> day;
+        auto start = std::chrono::steady_clock::now();
+        store.Read(store.LastTime() - 86400.0, store.LastTime(), day);
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("archive candles   : %llu in %zu blocks\n", (unsigned long long)store.Size(), store.BlockCount());
+        std::printf("archive last day  : %zu candles read in %.1f us\n", day.size(), elapsed);
+    }
+
+    void PrintAccount(const TradingState& state)
+    {
+        const Instrument& inst = state.instrument;
+        double win_rate = (state.total_trades_count > 0) ? ((double)state.winning_trades / state.total_trades_count * 100.0) : 0.0;
+
+        std::printf("open orders       : %zu\n", state.open_orders.size());
+        if (state.killed_orders > 0) std::printf("killed FOK orders : %d\n", state.killed_orders);
+        std::printf("long / short      : %.4f / %.4f\n", inst.ToAmount(state.long_pos.amount), inst.ToAmount(state.short_pos.amount));
+        std::printf("last price        : %.2f\n", inst.ToPrice(state.current_price));
+        std::printf("balance           : %.2f\n", inst.ToValue(state.balance));
+        std::printf("equity            : %.2f\n", inst.ToValue(state.equity));
+        std::printf("realized pnl      : %.2f\n", inst.ToValue(state.gross_profit - state.gross_loss));
+        std::printf("closed trades     : %d (win rate %.1f%%)\n", state.total_trades_count, win_rate);
+        std::printf("max drawdown      : %.2f%%\n", state.max_drawdown);
+
+        const PerformanceSummary& perf = state.performance;
+        std::printf("sharpe / sortino  : %.2f / %.2f\n", perf.sharpe, perf.sortino);
+        std::printf("calmar            : %.2f (annual return %.1f%%)\n", perf.calmar, perf.annual_return);
+        std::printf("volatility        : %.1f%% (1h %.1f%%, 1d %.1f%%), annualized\n", perf.volatility, perf.volatility_1h, perf.volatility_1d);
+        std::printf("avg win / loss    : %.2f / %.2f, expectancy %.2f\n", perf.avg_win, perf.avg_loss, perf.expectancy);
+    }
+
+    // Wall-clock order latency per OrderType, from PlaceOrder to acceptance and to each fill.
+    void PrintLatency(const TradingState& state)
+    {
+        static const char* const TYPE_NAMES[ORDER_TYPE_COUNT] = {"limit", "market", "fok"};
+        for (int type = 0; type < ORDER_TYPE_COUNT; ++type)
+        {
+            const LatencySummary& accept = state.accept_latency[type];
+            const LatencySummary& fill = state.fill_latency[type];
+            if (accept.count == 0) continue;
+
+            char p50[32], p99[32], p999[32], max[32];
+            FormatNanos(fill.p50_ns, p50, sizeof(p50));
+            FormatNanos(fill.p99_ns, p99, sizeof(p99));
+            FormatNanos(fill.p999_ns, p999, sizeof(p999));
+            FormatNanos(fill.max_ns, max, sizeof(max));
+            std::printf("%-6s to fill    : %llu fills of %llu orders, p50 %s, p99 %s, p99.9 %s, max %s\n",
+                TYPE_NAMES[type], (unsigned long long)fill.count, (unsigned long long)accept.count, p50, p99, p999, max);
+        }
+    }
+
+    // Runs the simulated market as the exchange side of a feed: every step's trades,
+    // changed book levels and candle are published, paced at --publish-rate.
+    // Snapshot requests are served for a second after the session ends.
+    void PublishMarket(const RunOptions& opts, FeedPublisher& publisher)
+    {
+        TradingEngine engine;
+        engine.Init(opts.seed);
+        if (opts.tick_sim > 0) engine.SetTicksPerCandle(opts.tick_sim);
+        MarketExporter<FeedPublisher> exporter(publisher);
+
+        auto start = std::chrono::steady_clock::now();
+        for (long long minute = 1; minute <= opts.minutes; ++minute)
+        {
+            engine.Step();
+            exporter.Capture(engine.state);
+            publisher.Flush();
+            if (opts.publish_rate > 0.0)
+            {
+                std::this_thread::sleep_until(start + std::chrono::duration<double>(minute / opts.publish_rate));
+            }
+        }
+        publisher.Finish();
+
+        auto linger_end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (std::chrono::steady_clock::now() < linger_end)
+        {
+            publisher.Flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void PrintPublisher(const FeedPublisher& publisher)
+    {
+        std::printf("feed published    : %llu messages in %llu packets (%llu dropped), %llu snapshots served\n",
+            (unsigned long long)publisher.LastSeq(), (unsigned long long)publisher.PacketsSent(),
+            (unsigned long long)publisher.PacketsDropped(), (unsigned long long)publisher.SnapshotsServed());
+    }
+
+    void PrintFeed(const FeedHandler& feed)
+    {
+        const FeedStats& s = feed.Stats();
+        std::printf("feed received     : %llu messages in %llu packets, last seq %llu\n",
+            (unsigned long long)s.messages, (unsigned long long)s.packets, (unsigned long long)feed.LastSeq());
+        std::printf("feed gaps         : %llu (%llu recovered by snapshot, %llu failed), %llu stale messages skipped\n",
+            (unsigned long long)s.gaps, (unsigned long long)s.recoveries, (unsigned long long)s.failed_recoveries, (unsigned long long)s.stale);
+        std::printf("feed losses       : %llu candles missed, %llu packets dropped while recovering\n",
+            (unsigned long long)s.candles_lost, (unsigned long long)s.held_dropped);
+    }
+
+    int Publish(const RunOptions& opts)
+    {
+        std::string group;
+        uint16_t port = 0;
+        FeedPublisher publisher;
+        if (!ParseFeed(opts.publish, group, port) || !publisher.Open(group, port, (uint16_t)(port + 1)))
+        {
+            std::fprintf(stderr, "cannot publish feed on %s\n", opts.publish.c_str());
+            return 1;
+        }
+        publisher.drop_every = opts.feed_drop;
+
+        auto start = std::chrono::steady_clock::now();
+        PublishMarket(opts, publisher);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("published minutes : %lld\n", opts.minutes);
+        std::printf("wall time         : %.3f s\n", elapsed);
+        PrintPublisher(publisher);
+        return 0;
+    }
+
+    // Matching side of the stand-in engine behind --serve-bridge. Market orders and
+    // marketable limits fill in full at the touch, FOK orders that are not marketable
+    // are rejected, and resting limits fill at their price once a candle trades through it.
+    class BridgeVenue
+    {
+    public:
+        explicit BridgeVenue(ShmBridgeHost& host) : host(host) {}
+
+        // Answers every queued request against the market as published so far.
+        void HandleOrders(const TradingState& market)
+        {
+            OrderRequest request;
+            while (host.PollOrder(request))
+            {
+                orders_received++;
+                if (request.action == ORDER_ACTION_NEW) HandleNew(market, request);
+                else if (request.action == ORDER_ACTION_CANCEL) HandleCancel(market, request);
+                else if (request.action == ORDER_ACTION_MODIFY) HandleModify(market, request);
+            }
+        }
+
+        void FillResting(const Candle& candle)
+        {
+            for (auto it = resting.begin(); it != resting.end();)
+            {
+                const OrderRequest& order = it->second;
+                bool crossed = order.is_buy ? candle.low <= order.price : candle.high >= order.price;
+                if (!crossed)
+                {
+                    ++it;
+                    continue;
+                }
+                Report(candle.time, order.order_id, EXEC_FILL, order.price, order.amount, 0);
+                it = resting.erase(it);
+            }
+        }
+
+        uint64_t OrdersReceived() const { return orders_received; }
+        uint64_t Fills() const { return fills; }
+
+    private:
+        ShmBridgeHost& host;
+        std::unordered_map<int32_t, OrderRequest> resting;
+        uint64_t orders_received = 0;
+        uint64_t fills = 0;
+
+        static double Now(const TradingState& market)
+        {
+            return market.candles.Empty() ? 0.0 : market.candles.Back().time;
+        }
+
+        // Price a buy (or sell) would trade at now.
+        static Price Touch(const TradingState& market, bool is_buy)
+        {
+            const auto& side = is_buy ? market.asks : market.bids;
+            return side.empty() ? market.current_price : side.front().price;
+        }
+
+        void HandleNew(const TradingState& market, const OrderRequest& order)
+        {
+            Price touch = Touch(market, order.is_buy);
+            bool marketable = order.order_type == ORDER_MARKET || (order.is_buy ? order.price >= touch : order.price <= touch);
+            if (marketable)
+            {
+                Report(Now(market), order.order_id, EXEC_FILL, touch, order.amount, 0);
+            }
+            else if (order.order_type == ORDER_LIMIT)
+            {
+                resting[order.order_id] = order;
+                Report(Now(market), order.order_id, EXEC_NEW, order.price, 0, order.amount);
+            }
+            else
+            {
+                Report(Now(market), order.order_id, EXEC_REJECTED, order.price, 0, 0);
+            }
+        }
+
+        void HandleCancel(const TradingState& market, const OrderRequest& request)
+        {
+            // An order that already filled cannot be cancelled; the dashboard has its fill.
+            bool found = resting.erase(request.order_id) > 0;
+            Report(Now(market), request.order_id, found ? EXEC_CANCELED : EXEC_REJECTED, request.price, 0, 0);
+        }
+
+        void HandleModify(const TradingState& market, const OrderRequest& request)
+        {
+            auto it = resting.find(request.order_id);
+            if (it == resting.end()) return;
+            it->second.amount = request.amount;
+            Report(Now(market), request.order_id, EXEC_REPLACED, it->second.price, 0, request.amount);
+        }
+
+        void Report(double time, int32_t order_id, ExecutionStatus status, Price price, Qty amount, Qty leaves)
+        {
+            ExecutionReport report = {};
+            report.time = time;
+            report.order_id = order_id;
+            report.status = status;
+            report.price = price;
+            report.amount = amount;
+            report.leaves = leaves;
+            host.WriteExecution(report);
+            if (status == EXEC_FILL) fills++;
+        }
+    };
+
+    // Stand-in for an external engine process: creates the bridge segment, waits for a
+    // dashboard to attach, then runs the simulated market for --minutes (paced at
+    // --publish-rate), matching the dashboard's orders with a BridgeVenue.
+    int ServeBridge(const RunOptions& opts)
+    {
+        ShmBridgeHost host;
+        if (!host.Create(opts.serve_bridge))
+        {
+            std::fprintf(stderr, "cannot create bridge segment %s\n", opts.serve_bridge.c_str());
+            return 1;
+        }
+        std::printf("waiting for a dashboard on %s\n", opts.serve_bridge.c_str());
+        std::fflush(stdout);
+        while (!host.ConsumerAttached()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        TradingEngine engine;
+        engine.Init(opts.seed);
+        if (opts.tick_sim > 0) engine.SetTicksPerCandle(opts.tick_sim);
+        MarketExporter<ShmBridgeHost> exporter(host);
+        BridgeVenue venue(host);
+
+        auto start = std::chrono::steady_clock::now();
+        long long minute = 1;
+        for (; minute <= opts.minutes && !host.ConsumerDetached(); ++minute)
+        {
+            venue.HandleOrders(engine.state);
+            engine.Step();
+            venue.FillResting(engine.state.candles.Back());
+            exporter.Capture(engine.state);
+            if (opts.publish_rate > 0.0)
+            {
+                std::this_thread::sleep_until(start + std::chrono::duration<double>(minute / opts.publish_rate));
+            }
+        }
+        host.Finish();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("served minutes    : %lld\n", minute - 1);
+        std::printf("wall time         : %.3f s\n", elapsed);
+        std::printf("bridge events     : %llu sent (%.0f/sec), %llu dropped\n", (unsigned long long)host.EventsSent(),
+            host.EventsSent() / elapsed, (unsigned long long)host.EventsDropped());
+        std::printf("bridge orders     : %llu received, %llu fills\n", (unsigned long long)venue.OrdersReceived(), (unsigned long long)venue.Fills());
+        return 0;
+    }
+
+    // Steps one engine per symbol, split across worker threads the way
+    // EngineThread shards them; symbols share nothing, so no locks are taken.
+    int RunSymbols(const RunOptions& opts)
+    {
+        int symbol_count = opts.symbols;
+        int thread_count = (opts.threads > 0) ? opts.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        thread_count = std::min(thread_count, symbol_count);
+
+        std::vector<TradingEngine> engines(symbol_count);
+        for (int i = 0; i < symbol_count; ++i)
+        {
+            std::snprintf(engines[i].state.instrument.symbol, sizeof(engines[i].state.instrument.symbol), "SIM-%d", i);
+            engines[i].Init(opts.seed + (uint32_t)i * 2);
+            if (opts.tick_sim > 0) engines[i].SetTicksPerCandle(opts.tick_sim);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < thread_count; ++w)
+        {
+            workers.emplace_back([&, w]()
+            {
+                for (int i = w; i < symbol_count; i += thread_count)
+                {
+                    TradingEngine& engine = engines[i];
+                    std::mt19937 strategy_rng(opts.seed + (uint32_t)i * 2 + 1);
+                    for (long long minute = 1; minute <= opts.minutes; ++minute)
+                    {
+                        engine.Step();
+                        if (opts.quote) QuoteAroundPrice(engine, strategy_rng, opts);
+                        if (opts.flatten_every > 0 && minute % opts.flatten_every == 0) engine.ClosePosition(true, true);
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        unsigned long long fills = 0;
+        double equity = 0.0;
+        double realized = 0.0;
+        for (const TradingEngine& engine : engines)
+        {
+            const Instrument& inst = engine.state.instrument;
+            fills += engine.state.order_history.TotalPushed();
+            equity += inst.ToValue(engine.state.equity);
+            realized += inst.ToValue(engine.state.gross_profit - engine.state.gross_loss);
+        }
+        long long minutes = opts.minutes * symbol_count;
+
+        std::printf("symbols / threads : %d / %d\n", symbol_count, thread_count);
+        std::printf("simulated minutes : %lld\n", minutes);
+        std::printf("wall time         : %.3f s\n", elapsed);
+        std::printf("ticks/sec         : %.0f\n", minutes / elapsed);
+        std::printf("fills             : %llu (%.0f/sec)\n", fills, fills / elapsed);
+        std::printf("portfolio equity  : %.2f\n", equity);
+        std::printf("realized pnl      : %.2f\n", realized);
+        return 0;
+    }
+
+    // Runs the quoting strategy once per generated path, each on a fresh engine
+    // fed by the path; with --no-quote only the paths themselves are measured.
+    int RunPaths(const RunOptions& opts)
+    {
+        MonteCarloConfig config;
+        config.paths = (uint64_t)opts.paths;
+        config.minutes = (int)std::min<long long>(opts.minutes, 1 << 30);
+        config.threads = opts.threads;
+        config.seed = opts.seed;
+
+        PathStrategy strategy;
+        if (opts.quote)
+        {
+            strategy = [&](uint64_t path, const Candle* candles, int minutes, PathResult& result)
+            {
+                PathSource source(candles, (size_t)minutes);
+                TradingEngine engine;
+                engine.state.instrument = config.instrument;
+                engine.SetMarketDataSource(&source);
+                engine.Init(opts.seed + (uint32_t)path, config.start_time);
+
+                const Instrument& inst = engine.state.instrument;
+                double initial_equity = inst.ToValue(engine.state.equity);
+                std::mt19937 strategy_rng(opts.seed + (uint32_t)path);
+
+                for (long long minute = 1; engine.Step(); ++minute)
+                {
+                    QuoteAroundPrice(engine, strategy_rng, opts);
+                    if (opts.flatten_every > 0 && minute % opts.flatten_every == 0) engine.ClosePosition(true, true);
+                }
+                result.pnl = inst.ToValue(engine.state.equity) - initial_equity;
+                result.trades = engine.state.total_trades_count;
+            };
+        }
+
+        MonteCarloSummary s = RunMonteCarlo(config, strategy);
+
+        std::printf("paths             : %llu x %d minutes\n", (unsigned long long)s.paths, config.minutes);
+        std::printf("wall time         : %.3f s\n", s.elapsed_s);
+        std::printf("candles/sec       : %.0f\n", s.candles / s.elapsed_s);
+        std::printf("price return      : mean %.2f%%, stddev %.2f%%, p05 %.2f%%, p95 %.2f%%\n", s.mean_return, s.stddev_return, s.return_p05, s.return_p95);
+        std::printf("price drawdown    : mean %.2f%%, worst %.2f%%\n", s.mean_drawdown, s.worst_drawdown);
+        if (opts.quote)
+        {
+            std::printf("strategy pnl      : mean %.2f, stddev %.2f, p05 %.2f, p95 %.2f\n", s.mean_pnl, s.stddev_pnl, s.pnl_p05, s.pnl_p95);
+            std::printf("profitable paths  : %.1f%%\n", s.profitable_fraction * 100.0);
+            std::printf("trades per path   : %.1f\n", s.mean_trades);
+        }
+        return 0;
+    }
+
+    int Replay(const RunOptions& opts)
+    {
+        TradingEngine engine;
+        ReplayStats stats;
+
+        ReplaySource market;
+        if (!opts.market_path.empty())
+        {
+            if (!market.Open(opts.market_path, engine.state.instrument))
+            {
+                std::fprintf(stderr, "cannot open market data %s\n", opts.market_path.c_str());
+                return 1;
+            }
+            engine.SetMarketDataSource(&market);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = ReplayJournal(opts.replay_path, engine, stats);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!ok && !stats.diverged)
+        {
+            std::fprintf(stderr, "cannot read journal %s\n", opts.replay_path.c_str());
+            return 1;
+        }
+
+        std::printf("replayed events   : %llu (%.0f/sec)\n", (unsigned long long)stats.events, stats.events / elapsed);
+        std::printf("replayed ticks    : %llu\n", (unsigned long long)stats.ticks);
+        std::printf("wall time         : %.3f s\n", elapsed);
+        if (stats.diverged)
+        {
+            std::printf("replay DIVERGED at tick %llu\n", (unsigned long long)stats.ticks);
+            return 2;
+        }
+        PrintAccount(engine.state);
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    RunOptions opts;
+    if (!ParseArgs(argc, argv, opts))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (!opts.replay_path.empty()) return Replay(opts);
+    if (!opts.publish.empty()) return Publish(opts);
+    if (!opts.serve_bridge.empty()) return ServeBridge(opts);
+    if (opts.paths > 0) return RunPaths(opts);
+    if (opts.symbols > 1) return RunSymbols(opts);
+
+    TradingEngine engine;
+    JournalWriter journal;
+    if (!opts.journal_path.empty())
+    {
+        if (!journal.Open(opts.journal_path, true))
+        {
+            std::fprintf(stderr, "cannot open journal %s\n", opts.journal_path.c_str());
+            return 1;
+        }
+        engine.SetJournal(&journal);
+    }
+
+    ReplaySource market;
+    if (!opts.market_path.empty())
+    {
+        if (!market.Open(opts.market_path, engine.state.instrument))
+        {
+            std::fprintf(stderr, "cannot open market data %s\n", opts.market_path.c_str());
+            return 1;
+        }
+        market.speed = opts.speed;
+        engine.SetMarketDataSource(&market);
+    }
+
+    FeedHandler feed;
+    FeedPublisher loopback;
+    std::thread loopback_thread;
+    if (!opts.feed.empty())
+    {
+        std::string group;
+        uint16_t port = 0;
+        if (!ParseFeed(opts.feed, group, port) || !feed.Open(group, port, (uint16_t)(port + 1)))
+        {
+            std::fprintf(stderr, "cannot open feed %s\n", opts.feed.c_str());
+            return 1;
+        }
+        engine.SetMarketDataSource(&feed);
+
+        // The receiver has joined the group, so the publisher's first packet is not lost.
+        if (opts.feed_loopback)
+        {
+            if (!loopback.Open(group, port, (uint16_t)(port + 1)))
+            {
+                std::fprintf(stderr, "cannot publish feed on %s\n", opts.feed.c_str());
+                return 1;
+            }
+            loopback.drop_every = opts.feed_drop;
+            loopback_thread = std::thread([&] { PublishMarket(opts, loopback); });
+        }
+    }
+
+    ShmBridge bridge;
+    if (!opts.bridge.empty())
+    {
+        if (!bridge.Open(opts.bridge))
+        {
+            std::fprintf(stderr, "cannot attach to bridge segment %s\n", opts.bridge.c_str());
+            return 1;
+        }
+        bridge.wait = true;
+        engine.SetMarketDataSource(&bridge);
+        engine.SetOrderGateway(&bridge);
+    }
+
+    MarketDataWriter market_out;
+    MarketExporter<MarketDataWriter> exporter(market_out);
+    if (!opts.export_path.empty() && !market_out.Open(opts.export_path, engine.state.instrument))
+    {
+        std::fprintf(stderr, "cannot write market data %s\n", opts.export_path.c_str());
+        return 1;
+    }
+
+    CandleStoreWriter archive;
+    if (!opts.archive_path.empty())
+    {
+        if (!archive.Open(opts.archive_path))
+        {
+            std::fprintf(stderr, "cannot open archive %s\n", opts.archive_path.c_str());
+            return 1;
+        }
+        engine.SetCandleArchive(&archive);
+    }
+
+    engine.Init(opts.seed);
+    if (opts.tick_sim > 0) engine.SetTicksPerCandle(opts.tick_sim);
+    std::mt19937 strategy_rng(opts.seed + 1);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // A paced source can produce no candle, or several, per step.
+    uint64_t last_candle = engine.state.candles.TotalPushed();
+    long long minutes = 0;
+    while (minutes < opts.minutes && engine.Step())
+    {
+        if (engine.state.candles.TotalPushed() == last_candle) continue;
+        minutes += (long long)(engine.state.candles.TotalPushed() - last_candle);
+        last_candle = engine.state.candles.TotalPushed();
+
+        if (market_out.IsOpen()) exporter.Capture(engine.state);
+        if (opts.quote) QuoteAroundPrice(engine, strategy_rng, opts);
+        if (opts.flatten_every > 0 && minutes % opts.flatten_every == 0) engine.ClosePosition(true, true);
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long fills = engine.state.order_history.TotalPushed();
+    if (loopback_thread.joinable()) loopback_thread.join();
+
+    std::printf("simulated minutes : %lld\n", minutes);
+    std::printf("wall time         : %.3f s\n", elapsed);
+    std::printf("ticks/sec         : %.0f\n", minutes / elapsed);
+    std::printf("fills             : %llu (%.0f/sec)\n", fills, fills / elapsed);
+    if (opts.tick_sim > 0) std::printf("simulated trades  : %lld (%.0f/sec)\n", minutes * opts.tick_sim, minutes * opts.tick_sim / elapsed);
+    if (journal.IsOpen()) std::printf("journal events    : %llu\n", (unsigned long long)journal.RecordCount());
+    if (loopback.IsOpen()) PrintPublisher(loopback);
+    if (!opts.feed.empty()) PrintFeed(feed);
+    if (bridge.IsOpen())
+    {
+        std::printf("bridge events     : %llu received\n", (unsigned long long)bridge.EventsReceived());
+        std::printf("bridge orders     : %llu sent, %llu refused (ring full)\n", (unsigned long long)bridge.OrdersSent(), (unsigned long long)bridge.OrdersRefused());
+        if (bridge.HostLost()) std::printf("bridge host       : exited without closing the segment\n");
+    }
+    if (archive.IsOpen())
+    {
+        archive.Close();
+        PrintArchive(opts.archive_path);
+    }
+    PrintAccount(engine.state);
+    engine.SummarizeLatency();
+    PrintLatency(engine.state);
+    return 0;
+}
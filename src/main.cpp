@@ -6,10 +6,49 @@
 #include "imgui_impl_opengl3.h"
 #include "implot.h"
 
-#include "core/TradingEngine.h"
+#include "core/EngineThread.h"
+#include "core/Profiler.h"
+#include "core/ShmBridge.h"
 #include "ui/DashboardUI.h"
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // Frames drawn after input so ImGui can settle hover, popups and animations.
+    constexpr int SETTLE_FRAMES = 3;
+    // Longest gap between frames while nothing changes (clock, text cursor).
+    constexpr double IDLE_REDRAW_S = 0.5;
+
+    bool input_pending = true;
+
+    // Installed before the ImGui backend, which chains to these callbacks.
+    void WatchInput(GLFWwindow* window)
+    {
+        glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { input_pending = true; });
+        glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { input_pending = true; });
+        glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { input_pending = true; });
+        glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { input_pending = true; });
+        glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { input_pending = true; });
+        glfwSetCursorEnterCallback(window, [](GLFWwindow*, int) { input_pending = true; });
+        glfwSetWindowFocusCallback(window, [](GLFWwindow*, int) { input_pending = true; });
+        glfwSetWindowRefreshCallback(window, [](GLFWwindow*) { input_pending = true; });
+    }
+}
+
+int main(int argc, char** argv) {
+    // --bridge NAME trades the first symbol through an external engine's shared memory segment.
+    ShmBridge bridge;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--bridge") != 0) continue;
+        if (!bridge.Open(argv[i + 1]))
+        {
+            std::fprintf(stderr, "cannot attach to bridge segment %s\n", argv[i + 1]);
+            return 1;
+        }
+    }
 
-int main() {
     if (!glfwInit()) return 1;
 
     const char* glsl_version = "#version 330";
@@ -34,40 +73,75 @@ int main() {
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
     DashboardUI::SetupStyle();
+    WatchInput(window);
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
-    TradingEngine engine;
-    engine.Init();
-
-    double last_time = glfwGetTime();
-
+    EngineThread engine;
+    const struct { const char* symbol; double price; } symbols[] =
+    {
+        {"BTC/USD", 42000.0}, {"BTC-PERP", 42050.0}, {"BTC-0329", 42600.0}, {"BTC-0628", 43200.0}
+    };
+    for (const auto& s : symbols)
+    {
+        Instrument inst;
+        std::snprintf(inst.symbol, sizeof(inst.symbol), "%s", s.symbol);
+        engine.AddSymbol(inst, s.price);
+    }
+    if (bridge.IsOpen()) engine.SetExternalVenue(0, &bridge, &bridge);
+    engine.SetWakeCallback([] { glfwPostEmptyEvent(); });
+    engine.Start("trading.journal");
+
+    UIState ui;
+    const TradingState& initial = engine.AcquireSnapshot();
+    ui.order_price = (float)initial.instrument.ToPrice(initial.current_price);
+
+    // Frames are drawn on demand: after input, when the engine publishes a new
+    // snapshot (its wake callback posts an empty event), or every IDLE_REDRAW_S.
+    uint64_t drawn_version = 0;
+    int settle_frames = 0;
+    double last_draw = 0.0;
     while (!glfwWindowShouldClose(window))
     {
+        if (settle_frames > 0) glfwPollEvents();
+        else glfwWaitEventsTimeout(IDLE_REDRAW_S);
+
+        if (input_pending)
+        {
+            input_pending = false;
+            settle_frames = SETTLE_FRAMES;
+        }
         double now = glfwGetTime();
-        double dt = now - last_time;
-        last_time = now;
-
-        glfwPollEvents();
-        engine.Update(dt);
+        bool engine_changed = engine.SnapshotVersion() != drawn_version;
+        if (settle_frames == 0 && !engine_changed && now - last_draw < IDLE_REDRAW_S) continue;
+        if (settle_frames > 0) --settle_frames;
+        last_draw = now;
+        drawn_version = engine.AcquireSnapshot().version;
 
+        PROFILE_SCOPE(PROF_FRAME);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        DashboardUI::Render(engine);
+        DashboardUI::Render(engine, ui);
 
-        ImGui::Render();
-        int w, h;
-        glfwGetFramebufferSize(window, &w, &h);
-        glViewport(0, 0, w, h);
-        glClearColor(0.13f, 0.14f, 0.17f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        
+        {
+            PROFILE_SCOPE(PROF_GL_RENDER);
+            ImGui::Render();
+            int w, h;
+            glfwGetFramebufferSize(window, &w, &h);
+            glViewport(0, 0, w, h);
+            glClearColor(0.13f, 0.14f, 0.17f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        PROFILE_SCOPE(PROF_SWAP_BUFFERS);
         glfwSwapBuffers(window);
     }
 
+    engine.Stop();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImPlot::DestroyContext();
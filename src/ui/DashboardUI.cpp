@@ -1,4 +1,7 @@
 #include "DashboardUI.h"
+#include "core/CandleLod.h"
+#include "core/CandleRangeIndex.h"
+#include "core/Profiler.h"
 #include "imgui.h"
 #include "implot.h"
 #include "imgui_internal.h" 
@@ -16,7 +19,32 @@ namespace
         return ss.str();
     }
 
-    void DrawCandlesticks(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, float width_sec)
+    // Index range [first, end) of the elements with t_min <= time <= t_max, for n
+    // elements sorted by time_at(i).
+    template <typename TimeAt>
+    void VisibleRange(size_t n, double t_min, double t_max, TimeAt time_at, size_t& first, size_t& end)
+    {
+        size_t lo = 0, hi = n;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (time_at(mid) < t_min) lo = mid + 1;
+            else hi = mid;
+        }
+        first = lo;
+
+        hi = n;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (time_at(mid) <= t_max) lo = mid + 1;
+            else hi = mid;
+        }
+        end = lo;
+    }
+
+    // Draws count candles from raw columns; prices are in ticks of tick_size.
+    void DrawCandlesticks(const double* xs, const Price* opens, const Price* closes, const Price* lows, const Price* highs, int count, double tick_size, float width_sec)
     {
         ImDrawList* draw_list = ImPlot::GetPlotDrawList();
         
@@ -29,10 +57,10 @@ namespace
         for (int i = 0; i < count; ++i)
         {
             double x = xs[i];
-            double open = opens[i];
-            double close = closes[i];
-            double low = lows[i];
-            double high = highs[i];
+            double open = opens[i] * tick_size;
+            double close = closes[i] * tick_size;
+            double low = lows[i] * tick_size;
+            double high = highs[i] * tick_size;
 
             ImVec2 wick_low  = ImPlot::PlotToPixels(x, low);
             ImVec2 wick_high = ImPlot::PlotToPixels(x, high);
@@ -125,11 +153,34 @@ void DashboardUI::SetupStyle()
 }
 
 
-void RenderChart(TradingEngine& engine)
+void RenderChart(EngineThread& engine, const TradingState& state, UIState& ui)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_CHART);
     ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 0.0f);
-    if (ImGui::Button(state.symbol)) { /* Symbol Search */ }
+    if (ImGui::Button(state.instrument.symbol)) ImGui::OpenPopup("SymbolSearch");
+    if (ImGui::BeginPopup("SymbolSearch"))
+    {
+        static char filter[16] = "";
+        if (ImGui::IsWindowAppearing()) ImGui::SetKeyboardFocusHere();
+        ImGui::SetNextItemWidth(160);
+        ImGui::InputTextWithHint("##SymbolFilter", "Search", filter, sizeof(filter));
+
+        for (int i = 0; i < engine.SymbolCount(); ++i)
+        {
+            const char* symbol = engine.GetInstrument(i).symbol;
+            if (filter[0] && !ImStristr(symbol, nullptr, filter, nullptr)) continue;
+
+            ImGui::PushID(i);
+            if (ImGui::Selectable(symbol, ui.symbol_id == i))
+            {
+                ui.symbol_id = i;
+                engine.SetActiveSymbol(i);
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndPopup();
+    }
     ImGui::SameLine();
     ImGui::TextDisabled("|"); ImGui::SameLine();
     
@@ -137,9 +188,9 @@ void RenderChart(TradingEngine& engine)
     for (int i=0; i<6; ++i)
     {
         if (i > 0) ImGui::SameLine();
-        bool selected = (state.timeframe_idx == i);
+        bool selected = (ui.timeframe_idx == i);
         if (selected) ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.26f, 0.59f, 0.98f, 1.0f));
-        if (ImGui::Button(tfs[i])) state.timeframe_idx = i;
+        if (ImGui::Button(tfs[i])) ui.timeframe_idx = i;
         if (selected) ImGui::PopStyleColor();
     }
     
@@ -159,15 +210,25 @@ void RenderChart(TradingEngine& engine)
     static const double intervals[] = {0.1, 0.5, 1.0, 3.0, 5.0, 10.0, 30.0, 60.0};
     static const char* interval_names[] = {"0.1s", "0.5s", "1s", "3s", "5s", "10s", "30s", "1m"};
     ImGui::SetNextItemWidth(80);
-    if (ImGui::SliderInt("##Speed", &state.simulation_interval_idx, 0, IM_ARRAYSIZE(intervals) - 1, interval_names[state.simulation_interval_idx]))
+    if (ImGui::SliderInt("##Speed", &ui.simulation_interval_idx, 0, IM_ARRAYSIZE(intervals) - 1, interval_names[ui.simulation_interval_idx]))
     {
-        state.simulation_update_interval_s = intervals[state.simulation_interval_idx];
+        engine.SetSimulationInterval(intervals[ui.simulation_interval_idx]);
     }
+
+    ImGui::SameLine();
+    static const int tick_counts[] = {0, 10, 100, 1000};
+    static const char* tick_names[] = {"Candles", "10 ticks", "100 ticks", "1000 ticks"};
+    ImGui::SetNextItemWidth(90);
+    if (ImGui::Combo("##TickSim", &ui.ticks_per_candle_idx, tick_names, IM_ARRAYSIZE(tick_names)))
+    {
+        engine.SetTicksPerCandle(tick_counts[ui.ticks_per_candle_idx]);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Trades simulated per 1m candle; resting orders fill on every trade that crosses them");
     
     ImGui::SameLine();
     if (ImGui::Button(state.is_paused ? " > " : " || "))
     {
-        state.is_paused = !state.is_paused;
+        engine.SetPaused(!state.is_paused);
     }
     if (ImGui::IsItemHovered()) ImGui::SetTooltip(state.is_paused ? "Resume Simulation" : "Pause Simulation");
     
@@ -190,64 +251,116 @@ void RenderChart(TradingEngine& engine)
     ImPlot::PushStyleVar(ImPlotStyleVar_PlotPadding, ImVec2(10, 10));
     if (ImPlot::BeginPlot("##MainChart", ImVec2(-1, -1), ImPlotFlags_NoTitle))
     {
-        std::vector<Candle> display_candles = engine.GetCandles(state.timeframe_idx);
-        int count = (int)display_candles.size();
-        
-        std::vector<double> times(count), opens(count), highs(count), lows(count), closes(count);
-        for(int i=0; i<count; ++i)
-        {
-            times[i] = display_candles[i].time;
-            opens[i] = display_candles[i].open;
-            highs[i] = display_candles[i].high;
-            lows[i] = display_candles[i].low;
-            closes[i] = display_candles[i].close;
-        }
+        const Instrument& inst = state.instrument;
+        const CandleSeries& display_candles = TradingEngine::GetCandles(state, ui.timeframe_idx);
+        int count = (int)display_candles.Size();
+        double first_time = (count > 0) ? display_candles.Front().time : 0.0;
+        double last_time = (count > 0) ? display_candles.Back().time : 0.0;
 
         ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_NoLabel);
         ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
         ImPlot::SetupAxis(ImAxis_Y1, nullptr, ImPlotAxisFlags_Opposite);
 
+        // Y auto-fit covers exactly the visible time window: the scrolled window, or
+        // the limits the user panned/zoomed to last frame.
+        static CandleRangeIndex y_ranges[TIMEFRAME_COUNT];
+        static ImPlotRect last_limits;
+        static bool has_limits = false;
+        CandleRangeIndex& y_range = y_ranges[ui.timeframe_idx];
+        y_range.Sync(display_candles);
+
         if (count > 0)
         {
+            double x_min = first_time, x_max = last_time;
             if (auto_scroll)
             {
-                double t_max = times.back();
+                double t_max = last_time;
                 double t_min = t_max - view_width;
                 ImPlot::SetupAxisLimits(ImAxis_X1, t_min, t_max + (view_width * 0.05), ImGuiCond_Always);
+                x_min = t_min;
+                x_max = t_max + (view_width * 0.05);
             } else
             {
-                ImPlot::SetupAxisLimits(ImAxis_X1, times.front(), times.back() + 300.0, ImGuiCond_FirstUseEver);
+                ImPlot::SetupAxisLimits(ImAxis_X1, first_time, last_time + 300.0, ImGuiCond_FirstUseEver);
+                if (has_limits)
+                {
+                    x_min = last_limits.X.Min;
+                    x_max = last_limits.X.Max;
+                }
             }
             
-            double min_y = *std::min_element(lows.begin(), lows.end());
-            double max_y = *std::max_element(highs.begin(), highs.end());
-            
-            if (auto_fit_y)
+            Price low, high;
+            if (auto_fit_y && y_range.Query(display_candles, x_min, x_max, low, high))
             {
-                 ImPlot::SetupAxisLimits(ImAxis_Y1, min_y * 0.999, max_y * 1.001, ImGuiCond_Always);
-            } else
+                 ImPlot::SetupAxisLimits(ImAxis_Y1, inst.ToPrice(low) * 0.999, inst.ToPrice(high) * 1.001, ImGuiCond_Always);
+            } else if (y_range.Query(display_candles, first_time, last_time, low, high))
             {
-                 ImPlot::SetupAxisLimits(ImAxis_Y1, min_y * 0.999, max_y * 1.001, ImGuiCond_FirstUseEver);
+                 ImPlot::SetupAxisLimits(ImAxis_Y1, inst.ToPrice(low) * 0.999, inst.ToPrice(high) * 1.001, ImGuiCond_FirstUseEver);
             }
         }
+        last_limits = ImPlot::GetPlotLimits();
+        has_limits = true;
         
-        double intervals_sec[] = {60.0, 300.0, 900.0, 3600.0, 14400.0, 86400.0};
-        float width = (float)(intervals_sec[state.timeframe_idx] * 0.7);
+        float width = (float)(TIMEFRAME_MINUTES[ui.timeframe_idx] * 60.0 * 0.7);
+
+        // Zoomed out past one candle per pixel, draw per-pixel envelopes from the LOD pyramid.
+        static CandleLod lods[TIMEFRAME_COUNT];
+        static CandleColumns envelopes;
+        CandleLod& lod = lods[ui.timeframe_idx];
+        lod.Sync(display_candles);
 
-        DrawCandlesticks("BTC/USD", times.data(), opens.data(), closes.data(), lows.data(), highs.data(), count, width);
+        double seconds_per_pixel = (last_limits.X.Max - last_limits.X.Min) / std::max(1.0f, ImPlot::GetPlotSize().x);
+        if (lod.Decimate(display_candles, last_limits.X.Min, last_limits.X.Max, seconds_per_pixel, envelopes))
+        {
+            DrawCandlesticks(envelopes.times.data(), envelopes.opens.data(), envelopes.closes.data(), envelopes.lows.data(), envelopes.highs.data(),
+                             (int)envelopes.Size(), inst.tick_size, (float)seconds_per_pixel);
+        } else
+        {
+            // Only candles whose body reaches into the plot are transformed and drawn.
+            size_t first, end;
+            const double* times = display_candles.Times();
+            VisibleRange(count, last_limits.X.Min - width, last_limits.X.Max + width,
+                         [&](size_t i) { return times[display_candles.Slot(i)]; }, first, end);
+
+            // The columns share one slot layout; a slice that wraps the ring is drawn as two runs.
+            auto draw_run = [&](size_t slot, size_t n)
+            {
+                if (n == 0) return;
+                DrawCandlesticks(times + slot, display_candles.Opens() + slot, display_candles.Closes() + slot,
+                                 display_candles.Lows() + slot, display_candles.Highs() + slot, (int)n, inst.tick_size, width);
+            };
+            if (first < end)
+            {
+                size_t slot = display_candles.Slot(first);
+                size_t contiguous = std::min(end - first, (size_t)count - slot);
+                draw_run(slot, contiguous);
+                draw_run(0, end - first - contiguous);
+            }
+        }
 
-        std::vector<double> buy_x, buy_y, sell_x, sell_y;
-        for (const auto& o : state.order_history)
+        // Fill markers of the visible window only; order history is in time order.
+        static std::vector<double> buy_x, buy_y, sell_x, sell_y;
+        buy_x.clear();
+        buy_y.clear();
+        sell_x.clear();
+        sell_y.clear();
+
+        size_t first_fill, end_fill;
+        double marker_margin = seconds_per_pixel * 8.0;
+        VisibleRange(state.order_history.Size(), last_limits.X.Min - marker_margin, last_limits.X.Max + marker_margin,
+                     [&](size_t i) { return state.order_history[i].time; }, first_fill, end_fill);
+        for (size_t i = first_fill; i < end_fill; ++i)
         {
+            const MyOrder& o = state.order_history[i];
             if (o.time == 0.0) continue;
             if (o.is_buy)
             {
                 buy_x.push_back(o.time);
-                buy_y.push_back(o.price);
+                buy_y.push_back(inst.ToPrice(o.price));
             } else
             {
                 sell_x.push_back(o.time);
-                sell_y.push_back(o.price);
+                sell_y.push_back(inst.ToPrice(o.price));
             }
         }
 
@@ -264,7 +377,7 @@ void RenderChart(TradingEngine& engine)
         
         if (count > 0)
         {
-            double cur_p = closes.back();
+            double cur_p = inst.ToPrice(display_candles.Back().close);
             ImPlot::TagY(cur_p, ImVec4(1, 0, 0, 1), "%.2f", cur_p);
         }
 
@@ -273,9 +386,10 @@ void RenderChart(TradingEngine& engine)
     ImPlot::PopStyleVar();
 }
 
-void RenderOrderBook(TradingEngine& engine)
+void RenderOrderBook(const TradingState& state)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_ORDER_BOOK);
+    const Instrument& inst = state.instrument;
     ImGui::PushStyleVar(ImGuiStyleVar_CellPadding, ImVec2(2, 1));
     if (ImGui::BeginTable("OrderBookTable", 3, ImGuiTableFlags_RowBg))
     {
@@ -288,9 +402,9 @@ void RenderOrderBook(TradingEngine& engine)
         {
             ImGui::TableNextRow();
             ImGui::TableNextColumn(); 
-            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%.2f", state.asks[i].price);
-            ImGui::TableNextColumn(); ImGui::Text("%.4f", state.asks[i].volume);
-            ImGui::TableNextColumn(); ImGui::Text("%.2f", state.asks[i].price * state.asks[i].volume);
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%.2f", inst.ToPrice(state.asks[i].price));
+            ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(state.asks[i].volume));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToValue(state.asks[i].price * state.asks[i].volume));
         }
 
         ImGui::TableNextRow();
@@ -298,8 +412,8 @@ void RenderOrderBook(TradingEngine& engine)
         ImGui::TableNextColumn(); 
         if (!state.asks.empty() && !state.bids.empty())
         {
-            double spread = state.asks[0].price - state.bids[0].price;
-            ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.8f, 1.0f), "%.2f", state.current_price);
+            double spread = inst.ToPrice(state.asks[0].price - state.bids[0].price);
+            ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.8f, 1.0f), "%.2f", inst.ToPrice(state.current_price));
             ImGui::SameLine();
             ImGui::TextDisabled("(Spread: %.2f)", spread);
         }
@@ -308,9 +422,9 @@ void RenderOrderBook(TradingEngine& engine)
         {
             ImGui::TableNextRow();
             ImGui::TableNextColumn(); 
-            ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.4f, 1.0f), "%.2f", bid.price);
-            ImGui::TableNextColumn(); ImGui::Text("%.4f", bid.volume);
-            ImGui::TableNextColumn(); ImGui::Text("%.2f", bid.price * bid.volume);
+            ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.4f, 1.0f), "%.2f", inst.ToPrice(bid.price));
+            ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(bid.volume));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToValue(bid.price * bid.volume));
         }
 
         ImGui::EndTable();
@@ -318,9 +432,10 @@ void RenderOrderBook(TradingEngine& engine)
     ImGui::PopStyleVar();
 }
 
-void RenderRecentTrades(TradingEngine& engine)
+void RenderRecentTrades(const TradingState& state)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_RECENT_TRADES);
+    const Instrument& inst = state.instrument;
     if (ImGui::BeginTable("TradesTable", 3, ImGuiTableFlags_ScrollY))
     {
         ImGui::TableSetupColumn("Price");
@@ -328,71 +443,86 @@ void RenderRecentTrades(TradingEngine& engine)
         ImGui::TableSetupColumn("Time");
         ImGui::TableHeadersRow();
 
-        for (const auto& t : state.trade_history)
+        ImGuiListClipper clipper;
+        clipper.Begin((int)state.trade_history.Size());
+        while (clipper.Step())
         {
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            ImGui::TextColored(t.is_buy ? ImVec4(0, 0.8f, 0.4f, 1) : ImVec4(1, 0.3f, 0.3f, 1), "%.2f", t.price);
-            ImGui::TableNextColumn();
-            ImGui::Text("%.4f", t.amount);
-            ImGui::TableNextColumn();
-            time_t rawtime = (time_t)t.time;
-            struct tm * timeinfo = localtime(&rawtime);
-            char buffer[80];
-            strftime(buffer,80,"%H:%M:%S",timeinfo);
-            ImGui::Text("%s", buffer);
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+            {
+                const Trade& t = state.trade_history[state.trade_history.Size() - 1 - row];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextColored(t.is_buy ? ImVec4(0, 0.8f, 0.4f, 1) : ImVec4(1, 0.3f, 0.3f, 1), "%.2f", inst.ToPrice(t.price));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", inst.ToAmount(t.amount));
+                ImGui::TableNextColumn();
+                time_t rawtime = (time_t)t.time;
+                struct tm * timeinfo = localtime(&rawtime);
+                char buffer[80];
+                strftime(buffer,80,"%H:%M:%S",timeinfo);
+                ImGui::Text("%s", buffer);
+            }
         }
         ImGui::EndTable();
     }
 }
 
-void RenderOrderEntry(TradingEngine& engine)
+void RenderOrderEntry(EngineThread& engine, const TradingState& state, UIState& ui)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_ORDER_ENTRY);
+    const Instrument& inst = state.instrument;
     
     ImGui::BeginTabBar("OrderType");
-    if (ImGui::BeginTabItem("Limit")) { state.order_type = 0; ImGui::EndTabItem(); }
-    if (ImGui::BeginTabItem("Market")) { state.order_type = 1; ImGui::EndTabItem(); }
-    if (ImGui::BeginTabItem("FOK")) { state.order_type = 2; ImGui::EndTabItem(); }
+    if (ImGui::BeginTabItem("Limit")) { ui.order_type = 0; ImGui::EndTabItem(); }
+    if (ImGui::BeginTabItem("Market")) { ui.order_type = 1; ImGui::EndTabItem(); }
+    if (ImGui::BeginTabItem("FOK")) { ui.order_type = 2; ImGui::EndTabItem(); }
     ImGui::EndTabBar();
 
     ImGui::Spacing();
 
     ImGui::BeginTabBar("ActionMode");
-    if (ImGui::BeginTabItem("  Open  ")) { state.is_reduce_mode = false; ImGui::EndTabItem(); }
-    if (ImGui::BeginTabItem("  Close ")) { state.is_reduce_mode = true;  ImGui::EndTabItem(); }
+    if (ImGui::BeginTabItem("  Open  ")) { ui.is_reduce_mode = false; ImGui::EndTabItem(); }
+    if (ImGui::BeginTabItem("  Close ")) { ui.is_reduce_mode = true;  ImGui::EndTabItem(); }
     ImGui::EndTabBar();
 
     ImGui::Spacing();
-    ImGui::Text("Equity: %.2f USD", state.equity);
-    ImGui::Text("Avail:  %.2f USD", state.balance);
+    ImGui::Text("Equity: %.2f USD", inst.ToValue(state.equity));
+    ImGui::Text("Avail:  %.2f USD", inst.ToValue(state.balance));
+    if (engine.SymbolCount() > 1)
+    {
+        AccountSummary total = engine.AggregateAccount();
+        ImGui::TextDisabled("Portfolio: %.2f USD (%d symbols)", total.equity, engine.SymbolCount());
+    }
     ImGui::Separator();
 
-    if (state.order_type == 0 || state.order_type == 2)
+    if (ui.order_type == 0 || ui.order_type == 2)
     {
-        ImGui::InputFloat("Price", &state.order_price, 10.0f, 100.0f, "%.2f");
+        ImGui::InputFloat("Price", &ui.order_price, 10.0f, 100.0f, "%.2f");
     } else
     {
-        ImGui::TextDisabled("Price: Market (%.2f)", state.current_price);
+        ImGui::TextDisabled("Price: Market (%.2f)", inst.ToPrice(state.current_price));
     }
     
-    ImGui::InputFloat("Amount", &state.order_amount, 0.01f, 0.1f, "%.4f");
+    ImGui::InputFloat("Amount", &ui.order_amount, 0.01f, 0.1f, "%.4f");
 
-    float estimated_price = (state.order_type == 1) ? state.current_price : state.order_price;
-    float total = estimated_price * state.order_amount;
+    float estimated_price = (ui.order_type == 1) ? (float)inst.ToPrice(state.current_price) : ui.order_price;
+    float total = estimated_price * ui.order_amount;
     
     ImGui::TextDisabled("Total: %.2f USD", total);
     ImGui::Separator();
     
+    Price order_price = inst.ToTicks(ui.order_price);
+    Qty order_amount = inst.ToLots(ui.order_amount);
+
     float w = ImGui::GetContentRegionAvail().x;
     float btn_w = (w * 0.5f) - 4;
 
-    if (!state.is_reduce_mode)
+    if (!ui.is_reduce_mode)
     {
         ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.0f, 0.7f, 0.3f, 1.0f));
         if (ImGui::Button("Open Long", ImVec2(btn_w, 40)))
         {
-            engine.PlaceOrder(true, state.order_type, state.order_price, state.order_amount, false); 
+            engine.PlaceOrder(true, ui.order_type, order_price, order_amount, false); 
         }
         ImGui::PopStyleColor();
 
@@ -401,7 +531,7 @@ void RenderOrderEntry(TradingEngine& engine)
         ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
         if (ImGui::Button("Open Short", ImVec2(btn_w, 40)))
         {
-            engine.PlaceOrder(false, state.order_type, state.order_price, state.order_amount, false); 
+            engine.PlaceOrder(false, ui.order_type, order_price, order_amount, false); 
         }
         ImGui::PopStyleColor();
     } else
@@ -409,7 +539,7 @@ void RenderOrderEntry(TradingEngine& engine)
         ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
         if (ImGui::Button("Close Long", ImVec2(btn_w, 40)))
         {
-            engine.PlaceOrder(false, state.order_type, state.order_price, state.order_amount, true);
+            engine.PlaceOrder(false, ui.order_type, order_price, order_amount, true);
         }
         ImGui::PopStyleColor();
 
@@ -418,15 +548,16 @@ void RenderOrderEntry(TradingEngine& engine)
         ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.0f, 0.7f, 0.3f, 1.0f));
         if (ImGui::Button("Close Short", ImVec2(btn_w, 40)))
         {
-            engine.PlaceOrder(true, state.order_type, state.order_price, state.order_amount, true);
+            engine.PlaceOrder(true, ui.order_type, order_price, order_amount, true);
         }
         ImGui::PopStyleColor();
     }
 }
 
-void RenderEquityWindow(TradingEngine& engine)
+void RenderEquityWindow(const TradingState& state)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_EQUITY);
+    const Instrument& inst = state.instrument;
     
     if (ImGui::BeginTable("StatsTable", 4, ImGuiTableFlags_Borders))
     {
@@ -440,27 +571,49 @@ void RenderEquityWindow(TradingEngine& engine)
 
         ImGui::TableNextRow();
         ImGui::TableNextColumn(); ImGui::Text("Profit Factor");
-        double pf = (state.gross_loss > 0) ? (state.gross_profit / state.gross_loss) : ((state.gross_profit > 0) ? 999.0 : 0.0);
+        double pf = (state.gross_loss > 0) ? ((double)state.gross_profit / state.gross_loss) : ((state.gross_profit > 0) ? 999.0 : 0.0);
         ImGui::TableNextColumn(); ImGui::Text("%.2f", pf);
 
         ImGui::TableNextColumn(); ImGui::Text("Total PnL");
-        double total_pnl = state.gross_profit - state.gross_loss;
+        double total_pnl = inst.ToValue(state.gross_profit - state.gross_loss);
         ImGui::TableNextColumn(); ImGui::TextColored(total_pnl >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", total_pnl);
 
+        const PerformanceSummary& perf = state.performance;
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Sharpe");
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", perf.sharpe);
+        ImGui::TableNextColumn(); ImGui::Text("Sortino");
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", perf.sortino);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Calmar");
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", perf.calmar);
+        ImGui::TableNextColumn(); ImGui::Text("Annual Return");
+        ImGui::TableNextColumn(); ImGui::Text("%.1f%%", perf.annual_return);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Volatility 1h / 1d");
+        ImGui::TableNextColumn(); ImGui::Text("%.1f%% / %.1f%%", perf.volatility_1h, perf.volatility_1d);
+        ImGui::TableNextColumn(); ImGui::Text("Volatility");
+        ImGui::TableNextColumn(); ImGui::Text("%.1f%%", perf.volatility);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Avg Win / Loss");
+        ImGui::TableNextColumn(); ImGui::Text("%.2f / %.2f", perf.avg_win, perf.avg_loss);
+        ImGui::TableNextColumn(); ImGui::Text("Expectancy");
+        ImGui::TableNextColumn(); ImGui::TextColored(perf.expectancy >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", perf.expectancy);
+
         ImGui::EndTable();
     }
 
-    if (state.equity_history.size() > 1)
+    if (state.equity_history.Size() > 1)
     {
         if (ImPlot::BeginPlot("##EquityCurve", ImVec2(-1, -1)))
         {
             ImPlot::SetupAxis(ImAxis_X1, "Time", ImPlotAxisFlags_NoLabel);
             ImPlot::SetupAxis(ImAxis_Y1, "Equity");
             
-            std::vector<double> xs(state.equity_history.size());
-            for(size_t i=0; i<xs.size(); ++i) xs[i] = (double)i;
-
-            ImPlot::PlotLine("Equity", xs.data(), state.equity_history.data(), (int)state.equity_history.size());
+            ImPlot::PlotLine("Equity", state.equity_history.Data(), (int)state.equity_history.Size(), 1.0, 0.0, 0, (int)state.equity_history.Offset());
             ImPlot::EndPlot();
         }
     } else
@@ -469,16 +622,23 @@ void RenderEquityWindow(TradingEngine& engine)
     }
 }
 
-void RenderTerminal(TradingEngine& engine)
+void RenderTerminal(EngineThread& engine, const TradingState& state)
 {
-    auto& state = engine.state;
+    PROFILE_SCOPE(PROF_RENDER_TERMINAL);
+    const Instrument& inst = state.instrument;
     if (ImGui::BeginTabBar("TerminalTabs"))
     {
         char buf[32];
         sprintf(buf, "Open Orders (%zu)", state.open_orders.size());
         if (ImGui::BeginTabItem(buf))
             {
-            if (ImGui::BeginTable("OrdersTable", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+            if (ImGui::Button("Cancel All")) engine.CancelAllOrders();
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel Buys")) engine.CancelOrders(true);
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel Sells")) engine.CancelOrders(false);
+
+            if (ImGui::BeginTable("OrdersTable", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY))
             {
                 ImGui::TableSetupColumn("ID");
                 ImGui::TableSetupColumn("Side");
@@ -489,28 +649,33 @@ void RenderTerminal(TradingEngine& engine)
                 ImGui::TableSetupColumn("Action");
                 ImGui::TableHeadersRow();
                 
-                int to_delete = -1;
-                for (int i=0; i<(int)state.open_orders.size(); ++i)
+                int to_cancel = -1;
+                ImGuiListClipper clipper;
+                clipper.Begin((int)state.open_orders.size());
+                while (clipper.Step())
                 {
-                    const auto& o = state.open_orders[i];
-                    ImGui::TableNextRow();
-                    ImGui::TableNextColumn(); ImGui::Text("%d", o.id);
-                    ImGui::TableNextColumn(); ImGui::TextColored(o.is_buy ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), o.is_buy ? "Buy" : "Sell");
-                    ImGui::TableNextColumn(); ImGui::Text(o.reduce_only ? "Reduce" : "Open");
-                    ImGui::TableNextColumn(); 
-                    if (o.order_type == 0) ImGui::Text("Limit");
-                    else if (o.order_type == 1) ImGui::Text("Market");
-                    else ImGui::Text("FOK");
-
-                    ImGui::TableNextColumn(); ImGui::Text("%.2f", o.price);
-                    ImGui::TableNextColumn(); ImGui::Text("%.4f", o.amount);
-                    ImGui::TableNextColumn(); 
-                    ImGui::PushID(i);
-                    if (ImGui::Button("Cancel")) to_delete = i;
-                    ImGui::PopID();
+                    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                    {
+                        const auto& o = state.open_orders[i];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%d", o.id);
+                        ImGui::TableNextColumn(); ImGui::TextColored(o.is_buy ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), o.is_buy ? "Buy" : "Sell");
+                        ImGui::TableNextColumn(); ImGui::Text(o.reduce_only ? "Reduce" : "Open");
+                        ImGui::TableNextColumn(); 
+                        if (o.order_type == 0) ImGui::Text("Limit");
+                        else if (o.order_type == 1) ImGui::Text("Market");
+                        else ImGui::Text("FOK");
+
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(o.price));
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(o.amount));
+                        ImGui::TableNextColumn(); 
+                        ImGui::PushID(o.id);
+                        if (ImGui::Button("Cancel")) to_cancel = o.id;
+                        ImGui::PopID();
+                    }
                 }
                 
-                if (to_delete != -1) engine.CancelOrder(to_delete);
+                if (to_cancel != -1) engine.CancelOrder(to_cancel);
                 
                 ImGui::EndTable();
             }
@@ -519,7 +684,7 @@ void RenderTerminal(TradingEngine& engine)
         
         if (ImGui::BeginTabItem("Positions"))
         {
-             if (state.long_pos.amount == 0.0 && state.short_pos.amount == 0.0)
+             if (state.long_pos.amount == 0 && state.short_pos.amount == 0)
                 {
                  ImGui::TextDisabled("No active positions");
              } else
@@ -535,30 +700,30 @@ void RenderTerminal(TradingEngine& engine)
                     ImGui::TableSetupColumn("Action");
                     ImGui::TableHeadersRow();
                     
-                    if (state.long_pos.amount > 0.0)
+                    if (state.long_pos.amount > 0)
                     {
                         ImGui::TableNextRow();
                         ImGui::TableNextColumn(); ImGui::TextColored(ImVec4(0,1,0,1), "LONG");
-                        ImGui::TableNextColumn(); ImGui::Text("%.4f", state.long_pos.amount);
-                        ImGui::TableNextColumn(); ImGui::Text("%.2f", state.long_pos.entry_price);
-                        ImGui::TableNextColumn(); ImGui::Text("%.2f", state.current_price);
-                        ImGui::TableNextColumn(); ImGui::TextColored(state.long_pos.unrealized_pnl >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", state.long_pos.unrealized_pnl);
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(state.long_pos.amount));
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(state.long_pos.EntryTicks()));
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(state.current_price));
+                        ImGui::TableNextColumn(); ImGui::TextColored(state.long_pos.unrealized_pnl >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", inst.ToValue(state.long_pos.unrealized_pnl));
                         ImGui::TableNextColumn(); 
-                        double roe = (state.long_pos.unrealized_pnl / (state.long_pos.amount * state.long_pos.entry_price)) * 100.0;
+                        double roe = ((double)state.long_pos.unrealized_pnl / state.long_pos.entry_cost) * 100.0;
                         ImGui::TextColored(roe >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f%%", roe);
                         ImGui::TableNextColumn(); if(ImGui::Button("Close##L")) engine.ClosePosition(true, false);
                     }
 
-                    if (state.short_pos.amount < 0.0)
+                    if (state.short_pos.amount < 0)
                     {
                         ImGui::TableNextRow();
                         ImGui::TableNextColumn(); ImGui::TextColored(ImVec4(1,0,0,1), "SHORT");
-                        ImGui::TableNextColumn(); ImGui::Text("%.4f", state.short_pos.amount);
-                        ImGui::TableNextColumn(); ImGui::Text("%.2f", state.short_pos.entry_price);
-                        ImGui::TableNextColumn(); ImGui::Text("%.2f", state.current_price);
-                        ImGui::TableNextColumn(); ImGui::TextColored(state.short_pos.unrealized_pnl >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", state.short_pos.unrealized_pnl);
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(state.short_pos.amount));
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(state.short_pos.EntryTicks()));
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(state.current_price));
+                        ImGui::TableNextColumn(); ImGui::TextColored(state.short_pos.unrealized_pnl >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f", inst.ToValue(state.short_pos.unrealized_pnl));
                         ImGui::TableNextColumn(); 
-                        double roe = (state.short_pos.unrealized_pnl / (std::abs(state.short_pos.amount) * state.short_pos.entry_price)) * 100.0;
+                        double roe = ((double)state.short_pos.unrealized_pnl / state.short_pos.entry_cost) * 100.0;
                         ImGui::TextColored(roe >= 0 ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), "%.2f%%", roe);
                         ImGui::TableNextColumn(); if(ImGui::Button("Close##S")) engine.ClosePosition(false, true);
                     }
@@ -567,10 +732,50 @@ void RenderTerminal(TradingEngine& engine)
              }
             ImGui::EndTabItem();
         }
-        
+
+        if (ImGui::BeginTabItem("Latency"))
+        {
+            static const char* const TYPE_NAMES[ORDER_TYPE_COUNT] = {"Limit", "Market", "FOK"};
+            if (ImGui::BeginTable("LatencyTable", 8, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+            {
+                ImGui::TableSetupColumn("Type");
+                ImGui::TableSetupColumn("Accepted");
+                ImGui::TableSetupColumn("Accept p99");
+                ImGui::TableSetupColumn("Fills");
+                ImGui::TableSetupColumn("Fill p50");
+                ImGui::TableSetupColumn("Fill p99");
+                ImGui::TableSetupColumn("Fill p99.9");
+                ImGui::TableSetupColumn("Fill max");
+                ImGui::TableHeadersRow();
+
+                char buf[32];
+                for (int type = 0; type < ORDER_TYPE_COUNT; ++type)
+                {
+                    const LatencySummary& accept = state.accept_latency[type];
+                    const LatencySummary& fill = state.fill_latency[type];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%s", TYPE_NAMES[type]);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)accept.count);
+                    ImGui::TableNextColumn(); FormatNanos(accept.p99_ns, buf, sizeof(buf)); ImGui::Text("%s", buf);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)fill.count);
+                    const int64_t fill_ns[4] = {fill.p50_ns, fill.p99_ns, fill.p999_ns, fill.max_ns};
+                    for (int64_t ns : fill_ns)
+                    {
+                        ImGui::TableNextColumn();
+                        if (fill.count == 0) { ImGui::TextDisabled("-"); continue; }
+                        FormatNanos(ns, buf, sizeof(buf));
+                        ImGui::Text("%s", buf);
+                    }
+                }
+                ImGui::EndTable();
+            }
+            ImGui::TextDisabled("From submit in the UI to each fill; resting limit orders include time in the book.");
+            ImGui::EndTabItem();
+        }
+
         if (ImGui::BeginTabItem("Trade History"))
         {
-            if (ImGui::BeginTable("HistTable", 5, ImGuiTableFlags_RowBg))
+            if (ImGui::BeginTable("HistTable", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
             {
                 ImGui::TableSetupColumn("Side");
                 ImGui::TableSetupColumn("Type");
@@ -578,18 +783,24 @@ void RenderTerminal(TradingEngine& engine)
                 ImGui::TableSetupColumn("Amount");
                 ImGui::TableSetupColumn("Time"); 
                 ImGui::TableHeadersRow();
-                for (const auto& o : state.order_history)
+                ImGuiListClipper clipper;
+                clipper.Begin((int)state.order_history.Size());
+                while (clipper.Step())
                 {
-                    ImGui::TableNextRow();
-                    ImGui::TableNextColumn(); ImGui::TextColored(o.is_buy ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), o.is_buy ? "Buy" : "Sell");
-                    ImGui::TableNextColumn(); 
-                    if (o.order_type == 0) ImGui::Text("Limit");
-                    else if (o.order_type == 1) ImGui::Text("Market");
-                    else ImGui::Text("FOK");
-
-                    ImGui::TableNextColumn(); ImGui::Text("%.2f", o.price);
-                    ImGui::TableNextColumn(); ImGui::Text("%.4f", o.amount);
-                    ImGui::TableNextColumn(); ImGui::Text("Just now"); 
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const MyOrder& o = state.order_history[state.order_history.Size() - 1 - row];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::TextColored(o.is_buy ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1), o.is_buy ? "Buy" : "Sell");
+                        ImGui::TableNextColumn(); 
+                        if (o.order_type == 0) ImGui::Text("Limit");
+                        else if (o.order_type == 1) ImGui::Text("Market");
+                        else ImGui::Text("FOK");
+
+                        ImGui::TableNextColumn(); ImGui::Text("%.2f", inst.ToPrice(o.price));
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", inst.ToAmount(o.amount));
+                        ImGui::TableNextColumn(); ImGui::Text("Just now"); 
+                    }
                 }
                 ImGui::EndTable();
             }
@@ -599,8 +810,66 @@ void RenderTerminal(TradingEngine& engine)
     }
 }
 
-void DashboardUI::Render(TradingEngine& engine)
+void RenderPerformance()
+{
+    PROFILE_SCOPE(PROF_RENDER_PERFORMANCE);
+    if (!Profiler::Enabled())
+    {
+        ImGui::TextDisabled("Built without TRADEUI_PROFILE: no stage timings.");
+        return;
+    }
+
+    ImGui::Text("Engine: %.0f ticks/s", Profiler::TicksPerSecond());
+    ProfileStats frame = Profiler::Summarize(PROF_FRAME);
+    ImGui::SameLine();
+    ImGui::TextDisabled("| Frame avg %.2f ms, p99 %.2f ms", frame.avg_us / 1000.0, frame.p99_us / 1000.0);
+
+    if (ImGui::BeginTable("ProfileTable", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Min us");
+        ImGui::TableSetupColumn("Avg us");
+        ImGui::TableSetupColumn("p99 us");
+        ImGui::TableSetupColumn("Samples");
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < PROF_STAGE_COUNT; ++i)
+        {
+            ProfileStage stage = (ProfileStage)i;
+            ProfileStats stats = Profiler::Summarize(stage);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", Profiler::StageName(stage));
+            if (stats.samples == 0)
+            {
+                ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+                ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+                ImGui::TableNextColumn(); ImGui::TextDisabled("-");
+                ImGui::TableNextColumn(); ImGui::TextDisabled("0");
+                continue;
+            }
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.min_us);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.avg_us);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.p99_us);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", stats.samples);
+        }
+        ImGui::EndTable();
+    }
+
+    static float frame_ms[Profiler::WINDOW];
+    int count = (int)Profiler::History(PROF_FRAME, frame_ms, Profiler::WINDOW);
+    if (count > 1 && ImPlot::BeginPlot("##FrameTime", ImVec2(-1, -1), ImPlotFlags_NoLegend))
+    {
+        ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_NoTickLabels);
+        ImPlot::SetupAxis(ImAxis_Y1, "Frame ms", ImPlotAxisFlags_AutoFit);
+        ImPlot::PlotLine("Frame", frame_ms, count);
+        ImPlot::EndPlot();
+    }
+}
+
+void DashboardUI::Render(EngineThread& engine, UIState& ui)
 {
+    PROFILE_SCOPE(PROF_RENDER_UI);
+    const TradingState& state = engine.AcquireSnapshot();
     static bool first_frame = true;
     static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_PassthruCentralNode; 
 
@@ -647,6 +916,7 @@ void DashboardUI::Render(TradingEngine& engine)
         ImGui::DockBuilderDockWindow("Order Entry", dock_right_bot);
         ImGui::DockBuilderDockWindow("Terminal", dock_bottom_left);
         ImGui::DockBuilderDockWindow("Equity", dock_bottom_right);
+        ImGui::DockBuilderDockWindow("Performance", dock_bottom_right);
 
         ImGui::DockBuilderFinish(dockspace_id);
     }
@@ -654,27 +924,31 @@ void DashboardUI::Render(TradingEngine& engine)
 
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(8,0));
     ImGui::Begin("Chart", nullptr, ImGuiWindowFlags_NoScrollbar);
-    RenderChart(engine);
+    RenderChart(engine, state, ui);
     ImGui::End();
     ImGui::PopStyleVar();
 
     ImGui::Begin("Order Book");
-    RenderOrderBook(engine);
+    RenderOrderBook(state);
     ImGui::End();
 
     ImGui::Begin("Recent Trades");
-    RenderRecentTrades(engine);
+    RenderRecentTrades(state);
     ImGui::End();
 
     ImGui::Begin("Order Entry");
-    RenderOrderEntry(engine);
+    RenderOrderEntry(engine, state, ui);
     ImGui::End();
 
     ImGui::Begin("Terminal");
-    RenderTerminal(engine);
+    RenderTerminal(engine, state);
     ImGui::End();
 
     ImGui::Begin("Equity");
-    RenderEquityWindow(engine);
+    RenderEquityWindow(state);
+    ImGui::End();
+
+    ImGui::Begin("Performance");
+    RenderPerformance();
     ImGui::End();
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #pragma once
-#include "core/TradingEngine.h"
+#include "core/EngineThread.h"
 
 namespace DashboardUI
 {
     void SetupStyle();
-    void Render(TradingEngine& engine);
+    void Render(EngineThread& engine, UIState& ui);
 }
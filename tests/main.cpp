@@ -0,0 +1,499 @@
+#include "core/TradingEngine.h"
+#include "core/Journal.h"
+#include "core/CandleStore.h"
+#include "core/FeedHandler.h"
+#include "core/PerformanceStats.h"
+#include "core/MonteCarlo.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// Self-checking tests, one group per ctest entry: TradingTests [GROUP...]
+// runs the named groups, or all of them without arguments. Files are
+// created in the working directory.
+namespace
+{
+    int g_failures = 0;
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+    bool Near(double a, double b, double tolerance = 1e-9)
+    {
+        return std::abs(a - b) <= tolerance * std::max(1.0, std::abs(b));
+    }
+
+    // Two-pass mean and sample variance of values[begin, end).
+    void Exact(const std::vector<double>& values, size_t begin, size_t end, double& mean, double& variance)
+    {
+        size_t n = end - begin;
+        mean = 0.0;
+        for (size_t i = begin; i < end; ++i) mean += values[i];
+        mean /= n;
+        double ss = 0.0;
+        for (size_t i = begin; i < end; ++i) ss += (values[i] - mean) * (values[i] - mean);
+        variance = (n > 1) ? ss / (n - 1) : 0.0;
+    }
+
+    bool Exists(const std::string& path)
+    {
+        return ::access(path.c_str(), F_OK) == 0;
+    }
+
+    void TestBook()
+    {
+        TradingEngine engine;
+        engine.Init(3, 1700000000.0);
+        engine.Step();
+        const Instrument& inst = engine.state.instrument;
+        const TradingState& state = engine.state;
+        Qty lot = inst.ToLots(1.0);
+
+        // A market buy cancels the user's own best ask instead of trading with it.
+        engine.PlaceOrder(false, ORDER_LIMIT, state.current_price + 1, lot);
+        CHECK(state.open_orders.size() == 1);
+        CHECK(!state.asks.empty() && state.asks.front().price == state.current_price + 1);
+        engine.PlaceOrder(true, ORDER_MARKET, 0, lot);
+        CHECK(state.long_pos.amount == lot);
+        CHECK(state.short_pos.amount == 0);
+        CHECK(state.open_orders.empty());
+        CHECK(state.asks.empty() || state.asks.front().price != state.current_price + 1);
+
+        // A FOK order does not count the user's own orders as liquidity.
+        CHECK(!state.bids.empty());
+        Price own_bid = state.bids.front().price + 1;
+        engine.PlaceOrder(true, ORDER_LIMIT, own_bid, lot);
+        engine.PlaceOrder(false, ORDER_FOK, own_bid, lot);
+        CHECK(state.killed_orders == 1);
+        CHECK(state.open_orders.size() == 1);
+        engine.CancelAllOrders();
+
+        // Reduce-only orders take no more than the position they close.
+        size_t history = state.order_history.Size();
+        engine.PlaceOrder(true, ORDER_MARKET, 0, lot, true);
+        CHECK(state.order_history.Size() == history);
+        CHECK(state.short_pos.amount == 0);
+        engine.PlaceOrder(false, ORDER_MARKET, 0, 3 * lot, true);
+        CHECK(state.long_pos.amount == 0);
+        CHECK(state.short_pos.amount == 0);
+        CHECK(state.order_history.Back().amount == lot);
+    }
+
+    void TestHistory()
+    {
+        // Tick fills, order fills and candle fills interleave; the chart binary-searches the result.
+        TradingEngine engine;
+        engine.Init(5, 1700000000.0);
+        engine.SetTicksPerCandle(30);
+        const Instrument& inst = engine.state.instrument;
+        for (int i = 0; i < 400; ++i)
+        {
+            if (i == 200) engine.SetTicksPerCandle(0);
+            engine.Step();
+            Price p = engine.state.current_price;
+            engine.PlaceOrder(true, ORDER_LIMIT, p - inst.ToTicks(3.0), inst.ToLots(0.1));
+            engine.PlaceOrder(false, ORDER_LIMIT, p + inst.ToTicks(3.0), inst.ToLots(0.1));
+            engine.PlaceOrder(i % 2 == 0, ORDER_MARKET, 0, inst.ToLots(0.05));
+        }
+
+        const RingBuffer<MyOrder>& history = engine.state.order_history;
+        CHECK(history.Size() > 400);
+        bool sorted = true;
+        for (size_t i = 1; i < history.Size(); ++i) sorted = sorted && history[i - 1].time <= history[i].time;
+        CHECK(sorted);
+        CHECK(history.Back().time <= engine.state.candles.Back().time + 60.0);
+    }
+
+    const int MISSING_ORDER_ID = 999999;
+
+    // A short session with every kind of order, journaled to path.
+    void RecordSession(const std::string& path, TradingEngine& engine)
+    {
+        JournalWriter journal;
+        CHECK(journal.Open(path, true));
+        engine.SetJournal(&journal);
+        engine.Init(42, 1700000000.0);
+
+        const Instrument& inst = engine.state.instrument;
+        for (int i = 0; i < 600; ++i)
+        {
+            engine.Step();
+            if (i % 40 == 0) engine.PlaceOrder(i % 80 == 0, ORDER_MARKET, 0, inst.ToLots(0.5));
+            if (i % 25 == 0)
+            {
+                bool is_buy = i % 50 == 0;
+                Price offset = inst.ToTicks(is_buy ? -20.0 : 20.0);
+                engine.PlaceOrder(is_buy, ORDER_LIMIT, engine.state.current_price + offset, inst.ToLots(0.2));
+            }
+            if (i == 200)
+            {
+                CHECK(!engine.CancelOrder(MISSING_ORDER_ID));
+                CHECK(!engine.ModifyOrder(MISSING_ORDER_ID, inst.ToLots(0.1)));
+            }
+            if (i == 300) engine.SetTicksPerCandle(20);
+            if (i == 450) engine.CancelOrders(true);
+            if (i == 500) engine.ClosePosition(true, true);
+        }
+        engine.SetJournal(nullptr);
+        journal.Close();
+    }
+
+    void TestJournal()
+    {
+        const std::string path = "test_journal.etj";
+        for (const std::string& stale : {path, path + ".diverged-1", path + ".diverged-2", path + ".tampered"})
+        {
+            std::remove(stale.c_str());
+        }
+
+        TradingEngine recorded;
+        RecordSession(path, recorded);
+
+        // Replaying the inputs rebuilds the same account.
+        TradingEngine replayed;
+        ReplayStats stats;
+        CHECK(ReplayJournal(path, replayed, stats));
+        CHECK(!stats.diverged);
+        CHECK(stats.ticks == 600);
+        CHECK(replayed.state.current_price == recorded.state.current_price);
+        CHECK(replayed.state.candles.TotalPushed() == recorded.state.candles.TotalPushed());
+        CHECK(replayed.state.balance == recorded.state.balance);
+        CHECK(replayed.state.total_trades_count == recorded.state.total_trades_count);
+        CHECK(replayed.state.open_orders.size() == recorded.state.open_orders.size());
+        CHECK(recorded.state.total_trades_count > 0);
+
+        // Cancels and modifies of unknown ids are not journaled.
+        {
+            JournalReader reader;
+            CHECK(reader.Open(path));
+            JournalRecord r;
+            int missing_records = 0;
+            while (reader.Next(r))
+            {
+                bool by_id = r.type == EVT_CANCEL_ORDER || r.type == EVT_MODIFY_ORDER;
+                if (by_id && r.order_id == MISSING_ORDER_ID) missing_records++;
+            }
+            CHECK(missing_records == 0);
+        }
+
+        // A journal whose ticks no longer reproduce is reported as diverged.
+        std::string tampered = path + ".tampered";
+        {
+            JournalReader reader;
+            JournalWriter writer;
+            CHECK(reader.Open(path));
+            CHECK(writer.Open(tampered, true));
+            JournalRecord r;
+            int ticks = 0;
+            while (reader.Next(r))
+            {
+                if (r.type == EVT_TICK && ++ticks == 100) r.a += 1;
+                writer.Append(r);
+            }
+        }
+        TradingEngine diverged;
+        ReplayStats diverged_stats;
+        CHECK(!ReplayJournal(tampered, diverged, diverged_stats));
+        CHECK(diverged_stats.diverged);
+        CHECK(diverged_stats.ticks == 100);
+
+        // A missing journal fails without diverging.
+        TradingEngine missing;
+        ReplayStats missing_stats;
+        CHECK(!ReplayJournal("test_journal_missing.etj", missing, missing_stats));
+        CHECK(!missing_stats.diverged);
+
+        // Setting a journal aside keeps it under the first free suffix.
+        CHECK(std::rename(tampered.c_str(), path.c_str()) == 0);
+        CHECK(SetAsideJournal(path) == path + ".diverged-1");
+        CHECK(!Exists(path));
+        TradingEngine again;
+        RecordSession(path, again);
+        CHECK(SetAsideJournal(path) == path + ".diverged-2");
+        CHECK(Exists(path + ".diverged-1") && Exists(path + ".diverged-2"));
+
+        for (const std::string& file : {path + ".diverged-1", path + ".diverged-2"}) std::remove(file.c_str());
+    }
+
+    // Multicasts minutes 1..minutes over loopback, one candle per packet, and
+    // consumes them into an engine until the end of the session.
+    uint64_t RunFeed(uint16_t port, int minutes, int drop_every, FeedStats& stats)
+    {
+        const std::string group = "239.255.42.99";
+        FeedHandler feed;
+        FeedPublisher publisher;
+        CHECK(feed.Open(group, port, (uint16_t)(port + 1)));
+        CHECK(publisher.Open(group, port, (uint16_t)(port + 1)));
+        publisher.drop_every = drop_every;
+
+        std::atomic<bool> done{false};
+        std::thread thread([&]
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int minute = 1; minute <= minutes; ++minute)
+            {
+                Price price = 4200000 + minute % 100;
+                publisher.WriteCandle({minute * 60.0, price, price + 5, price - 5, price + 1, 100});
+                publisher.Flush();
+                // Paced well below what loopback sustains, so only the dropped packets go missing.
+                std::this_thread::sleep_until(start + std::chrono::microseconds(minute * 50));
+            }
+            publisher.Finish();
+            while (!done.load())
+            {
+                publisher.Flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        TradingEngine engine;
+        engine.SetMarketDataSource(&feed);
+        engine.Init(1);
+        while (engine.Step()) {}
+        done.store(true);
+        thread.join();
+
+        stats = feed.Stats();
+        return engine.state.candles.TotalPushed();
+    }
+
+    void TestFeed()
+    {
+        // Every dropped packet is a gap the snapshot fills in full.
+        FeedStats stats;
+        uint64_t candles = RunFeed(30170, 4000, 25, stats);
+        CHECK(candles == 4000);
+        CHECK(stats.gaps > 0);
+        CHECK(stats.recoveries == stats.gaps);
+        CHECK(stats.failed_recoveries == 0);
+        CHECK(stats.candles_lost == 0);
+
+        // With every data packet dropped, the end of session reveals one gap that the
+        // snapshot only covers back FEED_SNAPSHOT_CANDLES minutes.
+        candles = RunFeed(30172, 3000, 1, stats);
+        CHECK(candles == FEED_SNAPSHOT_CANDLES);
+        CHECK(stats.gaps == 1);
+        CHECK(stats.failed_recoveries == 1);
+        CHECK(stats.candles_lost == 3000 - FEED_SNAPSHOT_CANDLES);
+    }
+
+    void TestStats()
+    {
+        // Returns around a drifting level, so the rolling mean moves.
+        std::mt19937 rng(7);
+        std::normal_distribution<double> noise(0.0, 1e-3);
+        std::vector<double> values;
+        for (int i = 0; i < 20000; ++i) values.push_back(noise(rng) + 1e-4 * std::sin(i / 500.0));
+
+        RunningStats running;
+        RollingStats rolling(PerformanceTracker::HOUR);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            running.Add(values[i]);
+            rolling.Add(values[i]);
+
+            size_t n = i + 1;
+            if (n != 1 && n != 2 && n != 59 && n != 60 && n != 61 && n % 997 != 0) continue;
+
+            double mean, variance;
+            Exact(values, 0, n, mean, variance);
+            CHECK(running.Count() == n);
+            CHECK(Near(running.Mean(), mean));
+            CHECK(Near(running.Variance(), variance));
+
+            size_t begin = (n > rolling.Window()) ? n - rolling.Window() : 0;
+            Exact(values, begin, n, mean, variance);
+            CHECK(rolling.Count() == n - begin);
+            CHECK(Near(rolling.Mean(), mean));
+            CHECK(Near(rolling.Variance(), variance, 1e-6));
+        }
+
+        // The tracker's ratios against the same figures from the whole equity curve.
+        PerformanceTracker tracker;
+        std::vector<double> returns;
+        double equity = 10000.0;
+        tracker.AddEquity(equity);
+        for (int i = 0; i < 5000; ++i)
+        {
+            double next = equity * (1.0 + values[i]);
+            returns.push_back(next / equity - 1.0);
+            equity = next;
+            tracker.AddEquity(equity);
+        }
+
+        TradingState state;
+        state.max_drawdown = 12.5;
+        PerformanceSummary summary;
+        tracker.Summarize(state, summary);
+
+        double mean, variance, downside_sq = 0.0;
+        Exact(returns, 0, returns.size(), mean, variance);
+        for (double r : returns) if (r < 0.0) downside_sq += r * r;
+        double annualize = std::sqrt(PerformanceTracker::PERIODS_PER_YEAR);
+        double annual_return = mean * PerformanceTracker::PERIODS_PER_YEAR * 100.0;
+
+        double hour_mean, hour_variance;
+        Exact(returns, returns.size() - PerformanceTracker::HOUR, returns.size(), hour_mean, hour_variance);
+
+        CHECK(summary.samples == returns.size());
+        CHECK(Near(summary.annual_return, annual_return, 1e-6));
+        CHECK(Near(summary.sharpe, mean / std::sqrt(variance) * annualize, 1e-6));
+        CHECK(Near(summary.sortino, mean / std::sqrt(downside_sq / returns.size()) * annualize, 1e-6));
+        CHECK(Near(summary.calmar, annual_return / 12.5, 1e-6));
+        CHECK(Near(summary.volatility, std::sqrt(variance) * annualize * 100.0, 1e-6));
+        CHECK(Near(summary.volatility_1h, std::sqrt(hour_variance) * annualize * 100.0, 1e-6));
+
+        // Breakeven closes are neither wins nor losses.
+        state.total_trades_count = 4;
+        state.winning_trades = 1;
+        state.losing_trades = 2;
+        state.gross_profit = state.instrument.ToTicks(300.0) * state.instrument.ToLots(1.0);
+        state.gross_loss = state.instrument.ToTicks(100.0) * state.instrument.ToLots(1.0);
+        tracker.Summarize(state, summary);
+        CHECK(Near(summary.avg_win, 300.0));
+        CHECK(Near(summary.avg_loss, 50.0));
+        CHECK(Near(summary.expectancy, 50.0));
+    }
+
+    void TestArchive()
+    {
+        const std::string path = "test_archive";
+        std::remove((path + ".cdat").c_str());
+        std::remove((path + ".cidx").c_str());
+
+        auto candle = [](int minute)
+        {
+            Price price = 4200000 + (minute * 37) % 1000;
+            return Candle{minute * 60.0, price, price + 9, price - 9, price + 3, 100 + minute};
+        };
+
+        CandleStoreWriter writer;
+        CHECK(writer.Open(path));
+        writer.flush_interval = 64;
+        for (int minute = 1; minute <= 300; ++minute) writer.Append(candle(minute));
+
+        // The open block is on disk up to the last flush_interval boundary.
+        CandleStore early;
+        CHECK(early.Open(path));
+        CHECK(early.Size() == 256);
+
+        const int block = (int)CANDLE_BLOCK_SIZE;
+        for (int minute = 301; minute <= block + 100; ++minute) writer.Append(candle(minute));
+        writer.Close();
+
+        // The block was rewritten in place under the early reader, which skips it.
+        std::vector<Candle> stale;
+        CHECK(early.Read(0.0, 1e12, stale) == 0);
+        early.Close();
+
+        // Reopening extends the partial block; older candles are ignored.
+        CHECK(writer.Open(path));
+        writer.Append(candle(5));
+        for (int minute = block + 101; minute <= block + 110; ++minute) writer.Append(candle(minute));
+        writer.Close();
+
+        CandleStore store;
+        CHECK(store.Open(path));
+        CHECK(store.Size() == CANDLE_BLOCK_SIZE + 110);
+        CHECK(store.BlockCount() == 2);
+
+        std::vector<Candle> out;
+        CHECK(store.Read(4000 * 60.0, 4200 * 60.0, out) == 201);
+        bool same = out.size() == 201;
+        for (size_t i = 0; same && i < out.size(); ++i)
+        {
+            Candle expected = candle(4000 + (int)i);
+            same = std::memcmp(&out[i], &expected, sizeof(Candle)) == 0;
+        }
+        CHECK(same);
+
+        store.Close();
+        std::remove((path + ".cdat").c_str());
+        std::remove((path + ".cidx").c_str());
+    }
+
+    void TestPaths()
+    {
+        MonteCarloConfig config;
+        PathGenerator generator(config.model, config.instrument, config.seed);
+        std::vector<Candle> candles;
+        const int minutes = 50;
+        generator.Generate(0, 1, minutes, config.instrument.ToTicks(config.start_price), 0.0, candles);
+
+        PathSource source(candles.data(), candles.size());
+        TradingEngine engine;
+        engine.state.instrument = config.instrument;
+        engine.SetMarketDataSource(&source);
+        engine.Init(7, 0.0);
+        const TradingState& state = engine.state;
+        Qty lot = state.instrument.ToLots(0.1);
+
+        // A path carries no depth of its own, so each candle is quoted around its close
+        // and the previous quotes are pulled.
+        int steps = 0;
+        while (engine.Step())
+        {
+            steps++;
+            CHECK(!state.bids.empty() && !state.asks.empty());
+            if (state.bids.empty() || state.asks.empty()) break;
+            CHECK(state.bids.front().price < state.current_price && state.asks.front().price > state.current_price);
+            if (steps % 10 == 0) engine.PlaceOrder(steps % 20 == 0, ORDER_MARKET, 0, lot);
+        }
+        CHECK(steps == minutes);
+        CHECK(state.order_history.Size() == minutes / 10);
+    }
+
+    struct TestGroup
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const TestGroup GROUPS[] = {
+        {"book", TestBook},
+        {"history", TestHistory},
+        {"journal", TestJournal},
+        {"feed", TestFeed},
+        {"stats", TestStats},
+        {"archive", TestArchive},
+        {"paths", TestPaths},
+    };
+}
+
+int main(int argc, char** argv)
+{
+    int ran = 0;
+    for (const TestGroup& group : GROUPS)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected = selected || !std::strcmp(argv[i], group.name);
+        if (!selected) continue;
+
+        int before = g_failures;
+        group.run();
+        std::printf("%-10s %s\n", group.name, (g_failures == before) ? "ok" : "FAILED");
+        ran++;
+    }
+
+    if (ran == 0)
+    {
+        std::fprintf(stderr, "no test group matches\n");
+        return 1;
+    }
+    return (g_failures == 0) ? 0 : 1;
+}